@@ -0,0 +1,189 @@
+#include "BVH.h"
+#include <algorithm>
+
+namespace {
+
+// World-space padding added around each leaf box
+const float kFatMargin = 0.1f;
+
+} // namespace
+
+BVH::BVH() : root(kNullNode), freeList(kNullNode) {}
+
+int BVH::AllocateNode() {
+    if (freeList == kNullNode) {
+        nodes.push_back(Node());
+        freeList = (int)nodes.size() - 1;
+        nodes[freeList].parent = kNullNode;
+    }
+
+    int node = freeList;
+    freeList = nodes[node].parent;
+    nodes[node].parent = kNullNode;
+    nodes[node].left = kNullNode;
+    nodes[node].right = kNullNode;
+    nodes[node].height = 0;
+    nodes[node].userData = 0;
+    return node;
+}
+
+void BVH::FreeNode(int node) {
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+int BVH::Insert(const AABB& bounds, size_t userData) {
+    int leaf = AllocateNode();
+    nodes[leaf].bounds = AABB(bounds.min - glm::vec3(kFatMargin), bounds.max + glm::vec3(kFatMargin));
+    nodes[leaf].userData = userData;
+    InsertLeaf(leaf);
+    return leaf;
+}
+
+void BVH::Remove(int proxy) {
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+}
+
+bool BVH::Move(int proxy, const AABB& bounds) {
+    if (nodes[proxy].bounds.Contains(bounds))
+        return false;
+
+    RemoveLeaf(proxy);
+    nodes[proxy].bounds = AABB(bounds.min - glm::vec3(kFatMargin), bounds.max + glm::vec3(kFatMargin));
+    InsertLeaf(proxy);
+    return true;
+}
+
+void BVH::InsertLeaf(int leaf) {
+    if (root == kNullNode) {
+        root = leaf;
+        nodes[root].parent = kNullNode;
+        return;
+    }
+
+    // Walk down choosing the child that grows the total surface area the least
+    AABB leafBounds = nodes[leaf].bounds; // Copy: AllocateNode below may grow the node array
+    int index = root;
+    while (!nodes[index].IsLeaf()) {
+        int left = nodes[index].left;
+        int right = nodes[index].right;
+
+        float area = nodes[index].bounds.GetSurfaceArea();
+        float combinedArea = AABB::Union(nodes[index].bounds, leafBounds).GetSurfaceArea();
+
+        // Cost of making a new parent for this node and the leaf, and the minimum cost pushed down
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int child) {
+            float newArea = AABB::Union(leafBounds, nodes[child].bounds).GetSurfaceArea();
+            if (nodes[child].IsLeaf())
+                return newArea + inheritanceCost;
+            return newArea - nodes[child].bounds.GetSurfaceArea() + inheritanceCost;
+        };
+
+        float leftCost = descendCost(left);
+        float rightCost = descendCost(right);
+        if (cost < leftCost && cost < rightCost)
+            break;
+
+        index = leftCost < rightCost ? left : right;
+    }
+
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].bounds = AABB::Union(leafBounds, nodes[sibling].bounds);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].left = sibling;
+    nodes[newParent].right = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == kNullNode) {
+        root = newParent;
+    }
+    else if (nodes[oldParent].left == sibling) {
+        nodes[oldParent].left = newParent;
+    }
+    else {
+        nodes[oldParent].right = newParent;
+    }
+
+    Refit(nodes[leaf].parent);
+}
+
+void BVH::RemoveLeaf(int leaf) {
+    if (leaf == root) {
+        root = kNullNode;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+    // The sibling takes the parent's place
+    if (grandParent == kNullNode) {
+        root = sibling;
+        nodes[sibling].parent = kNullNode;
+    }
+    else {
+        if (nodes[grandParent].left == parent)
+            nodes[grandParent].left = sibling;
+        else
+            nodes[grandParent].right = sibling;
+        nodes[sibling].parent = grandParent;
+        Refit(grandParent);
+    }
+    FreeNode(parent);
+}
+
+void BVH::Refit(int node) {
+    while (node != kNullNode) {
+        const Node& left = nodes[nodes[node].left];
+        const Node& right = nodes[nodes[node].right];
+        nodes[node].bounds = AABB::Union(left.bounds, right.bounds);
+        nodes[node].height = 1 + std::max(left.height, right.height);
+        node = nodes[node].parent;
+    }
+}
+
+void BVH::Query(const Frustum& frustum, std::vector<size_t>& results) const {
+    if (root == kNullNode)
+        return;
+
+    stack.clear();
+    stack.push_back(root);
+
+    // Pop up to four nodes at a time and test them against all six planes in one go
+    AABB4 batch;
+    int batchNodes[4];
+    while (!stack.empty()) {
+        int count = 0;
+        while (count < 4 && !stack.empty()) {
+            batchNodes[count] = stack.back();
+            stack.pop_back();
+            batch.Set(count, nodes[batchNodes[count]].bounds);
+            ++count;
+        }
+
+        int visible = frustum.Intersects(batch);
+        for (int i = 0; i < count; ++i) {
+            if (!(visible & (1 << i)))
+                continue;
+
+            const Node& node = nodes[batchNodes[i]];
+            if (node.IsLeaf()) {
+                results.push_back(node.userData);
+            }
+            else {
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+            }
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include "Bounds.h"
+#include "Frustum.h"
+
+// Dynamic AABB tree over scene objects. Leaves store a slightly enlarged ("fat") box so small
+// movements do not touch the tree; when an object escapes its fat box the leaf is reinserted
+// and every ancestor on the path is refit.
+class BVH {
+public:
+    static const int kNullNode = -1;
+
+    BVH();
+
+    // Returns the proxy id used to move or remove the object later
+    int Insert(const AABB& bounds, size_t userData);
+    void Remove(int proxy);
+    // Returns true if the tree had to be restructured
+    bool Move(int proxy, const AABB& bounds);
+
+    // Appends the userData of every leaf whose fat box touches the frustum
+    void Query(const Frustum& frustum, std::vector<size_t>& results) const;
+
+    const AABB& GetFatBounds(int proxy) const { return nodes[proxy].bounds; }
+    int GetHeight() const { return root == kNullNode ? 0 : nodes[root].height; }
+
+private:
+    struct Node {
+        AABB bounds;
+        size_t userData;
+        int parent;   // Doubles as the next link while the node is on the free list
+        int left;
+        int right;
+        int height;   // 0 for leaves, -1 for free nodes
+
+        bool IsLeaf() const { return left == kNullNode; }
+    };
+
+    std::vector<Node> nodes;
+    int root;
+    int freeList;
+    mutable std::vector<int> stack; // Traversal scratch, reused across queries
+
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    void Refit(int node);
+};
+
+#endif // BVH_H
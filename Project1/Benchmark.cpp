@@ -0,0 +1,343 @@
+#include "Benchmark.h"
+#include "HeadlessContext.h"
+#include "Renderer.h"
+#include "Camera.h"
+#include "Scene.h"
+#include "Mesh.h"
+#include "GeometryArena.h"
+#include "Texture.h"
+#include "TextureLoader.h"
+#include "Primitives.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+// std::mt19937 output is specified by the standard, the real distributions are not;
+// map to floats ourselves so the scene is identical on every toolchain.
+class Random {
+public:
+    explicit Random(unsigned int seed) : engine(seed) {}
+
+    float Next() { return (engine() >> 8) * (1.0f / 16777216.0f); }
+    float Range(float lo, float hi) { return lo + (hi - lo) * Next(); }
+
+private:
+    std::mt19937 engine;
+};
+
+glm::mat4 BoxTransform(const glm::vec3& center, const glm::vec3& size) {
+    return glm::scale(glm::translate(glm::mat4(1.0f), center), size);
+}
+
+float BuildScene(Scene& scene, const BenchmarkConfig& config, const std::vector<Texture>& textures) {
+    Random random(config.seed);
+
+    const float spacing = 2.5f;
+    int side = std::max(1, (int)std::ceil(std::sqrt((float)config.cubeCount)));
+    float extent = side * spacing * 0.5f;
+    VertexFormat format = config.compactVertices ? VertexFormat::Compact : VertexFormat::Full;
+    size_t cube = scene.AddMesh(Mesh(cubeVertices, cubeIndices, textures, format));
+
+    // Floor slab under the grid so the shadow and SSAO passes have receivers
+    scene.AddObject(cube, BoxTransform(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(extent * 2.0f + 4.0f, 0.2f, extent * 2.0f + 4.0f)));
+
+    std::vector<glm::mat4> cubeTransforms;
+    cubeTransforms.reserve(config.cubeCount);
+    for (int i = 0; i < config.cubeCount; ++i) {
+        int x = i % side;
+        int z = i / side;
+        float size = random.Range(0.5f, 1.5f);
+        glm::vec3 center(
+            (x + 0.5f) * spacing - extent + random.Range(-0.4f, 0.4f),
+            -0.9f + size * 0.5f + random.Range(0.0f, 1.0f),
+            (z + 0.5f) * spacing - extent + random.Range(-0.4f, 0.4f));
+        cubeTransforms.push_back(BoxTransform(center, glm::vec3(size)));
+    }
+    scene.AddInstances(cube, cubeTransforms);
+
+    scene.SetDirectionalLight(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(-0.2f, -1.0f, -0.3f),
+        glm::vec3(0.05f), glm::vec3(0.4f), glm::vec3(0.5f));
+
+    for (int i = 0; i < config.pointLightCount; ++i) {
+        glm::vec3 position(random.Range(-extent, extent), random.Range(0.5f, 3.0f), random.Range(-extent, extent));
+        glm::vec3 color(random.Range(0.3f, 1.0f), random.Range(0.3f, 1.0f), random.Range(0.3f, 1.0f));
+        scene.AddPointLight(position, color * 0.05f, color * 0.8f, color, 1.0f, 0.09f, 0.032f);
+    }
+
+    for (int i = 0; i < config.spotLightCount; ++i) {
+        glm::vec3 position(random.Range(-extent, extent), random.Range(3.0f, 6.0f), random.Range(-extent, extent));
+        glm::vec3 target(random.Range(-extent, extent), -1.0f, random.Range(-extent, extent));
+        glm::vec3 color(random.Range(0.5f, 1.0f), random.Range(0.5f, 1.0f), random.Range(0.5f, 1.0f));
+        scene.AddSpotLight(position, glm::normalize(target - position), glm::vec3(0.0f), color, color,
+            1.0f, 0.09f, 0.032f, glm::cos(glm::radians(12.5f)), glm::cos(glm::radians(17.5f)));
+    }
+
+    return extent;
+}
+
+// One full orbit over the measured frames, bobbing up and down twice so the view sweeps
+// both grazing and top-down angles
+glm::vec3 CameraPathPosition(int frame, int frameCount, float extent) {
+    float t = (float)frame / (float)std::max(1, frameCount);
+    float angle = t * 2.0f * 3.14159265f;
+    float radius = extent * 1.2f + 4.0f;
+    float height = radius * (0.35f + 0.15f * std::sin(angle * 2.0f));
+    return glm::vec3(radius * std::cos(angle), height, radius * std::sin(angle));
+}
+
+double Percentile(std::vector<double> samples, double p) {
+    if (samples.empty())
+        return 0.0;
+    size_t index = (size_t)(p * (samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+std::string JsonEscape(const char* text) {
+    std::string result;
+    for (const char* c = text ? text : ""; *c; ++c) {
+        if (*c == '"' || *c == '\\')
+            result += '\\';
+        result += *c;
+    }
+    return result;
+}
+
+bool WriteResults(const BenchmarkConfig& config, const std::vector<double>& frameTimes, const Profiler& profiler) {
+    std::ofstream file(config.outputPath);
+    if (!file) {
+        std::cerr << "Failed to open benchmark output: " << config.outputPath << std::endl;
+        return false;
+    }
+
+    double total = 0.0;
+    for (double ms : frameTimes) {
+        total += ms;
+    }
+    double mean = frameTimes.empty() ? 0.0 : total / frameTimes.size();
+
+    file << std::fixed << std::setprecision(4);
+    file << "{\n";
+    file << "  \"config\": {\"width\": " << config.width << ", \"height\": " << config.height
+        << ", \"warmupFrames\": " << config.warmupFrames << ", \"frames\": " << config.frames
+        << ", \"cubes\": " << config.cubeCount << ", \"pointLights\": " << config.pointLightCount
+        << ", \"spotLights\": " << config.spotLightCount << ", \"seed\": " << config.seed
+        << ", \"vertexFormat\": \"" << (config.compactVertices ? "compact" : "full") << "\""
+        << ", \"occlusionCulling\": " << (config.occlusionCulling ? "true" : "false")
+        << ", \"ssao\": " << (config.ssao ? "true" : "false") << ", \"shadows\": " << (config.shadows ? "true" : "false")
+        << ", \"ssaoDivisor\": " << config.ssaoDivisor << ", \"ssaoSamples\": " << config.ssaoSamples
+        << ", \"temporal\": " << (config.temporal ? "true" : "false") << ", \"shadowSamples\": " << config.shadowSamples
+        << ", \"shadowFilter\": \"" << config.shadowFilter << "\"},\n";
+    file << "  \"gl\": {\"renderer\": \"" << JsonEscape((const char*)glGetString(GL_RENDERER))
+        << "\", \"version\": \"" << JsonEscape((const char*)glGetString(GL_VERSION)) << "\"},\n";
+    file << "  \"frameTimeMs\": {\"min\": " << (frameTimes.empty() ? 0.0 : *std::min_element(frameTimes.begin(), frameTimes.end()))
+        << ", \"max\": " << (frameTimes.empty() ? 0.0 : *std::max_element(frameTimes.begin(), frameTimes.end()))
+        << ", \"mean\": " << mean
+        << ", \"p50\": " << Percentile(frameTimes, 0.50)
+        << ", \"p95\": " << Percentile(frameTimes, 0.95)
+        << ", \"p99\": " << Percentile(frameTimes, 0.99) << "},\n";
+    file << "  \"passes\": [";
+
+    std::vector<Profiler::PassStats> passes = profiler.GetPassStats();
+    for (size_t i = 0; i < passes.size(); ++i) {
+        const auto& pass = passes[i];
+        file << (i == 0 ? "\n" : ",\n")
+            << "    {\"name\": \"" << JsonEscape(pass.name.c_str()) << "\", \"samples\": " << pass.samples
+            << ", \"cpuP50\": " << pass.cpuP50 << ", \"cpuP95\": " << pass.cpuP95 << ", \"cpuP99\": " << pass.cpuP99
+            << ", \"gpuP50\": " << pass.gpuP50 << ", \"gpuP95\": " << pass.gpuP95 << ", \"gpuP99\": " << pass.gpuP99 << "}";
+    }
+    file << "\n  ]\n}\n";
+    return true;
+}
+
+bool ParseInt(const char* text, int minimum, int& out) {
+    char* end = nullptr;
+    long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < minimum)
+        return false;
+    out = (int)value;
+    return true;
+}
+
+} // namespace
+
+bool IsBenchmarkRequested(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--benchmark") == 0)
+            return true;
+    }
+    return false;
+}
+
+bool ParseBenchmarkArgs(int argc, char** argv, BenchmarkConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--benchmark")
+            continue;
+
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+
+        int seed = 0;
+        bool ok = true;
+        if (arg == "--frames") ok = ParseInt(value, 1, config.frames);
+        else if (arg == "--warmup") ok = ParseInt(value, 0, config.warmupFrames);
+        else if (arg == "--cubes") ok = ParseInt(value, 0, config.cubeCount);
+        else if (arg == "--point-lights") ok = ParseInt(value, 0, config.pointLightCount);
+        else if (arg == "--spot-lights") ok = ParseInt(value, 0, config.spotLightCount);
+        else if (arg == "--width") ok = ParseInt(value, 1, config.width);
+        else if (arg == "--height") ok = ParseInt(value, 1, config.height);
+        else if (arg == "--seed") { ok = ParseInt(value, 0, seed); config.seed = (unsigned int)seed; }
+        else if (arg == "--vertex-format") {
+            ok = std::strcmp(value, "full") == 0 || std::strcmp(value, "compact") == 0;
+            config.compactVertices = std::strcmp(value, "compact") == 0;
+        }
+        else if (arg == "--occlusion-culling") {
+            ok = std::strcmp(value, "on") == 0 || std::strcmp(value, "off") == 0;
+            config.occlusionCulling = std::strcmp(value, "on") == 0;
+        }
+        else if (arg == "--ssao") {
+            ok = std::strcmp(value, "on") == 0 || std::strcmp(value, "off") == 0;
+            config.ssao = std::strcmp(value, "on") == 0;
+        }
+        else if (arg == "--shadows") {
+            ok = std::strcmp(value, "on") == 0 || std::strcmp(value, "off") == 0;
+            config.shadows = std::strcmp(value, "on") == 0;
+        }
+        else if (arg == "--ssao-resolution") {
+            if (std::strcmp(value, "full") == 0) config.ssaoDivisor = 1;
+            else if (std::strcmp(value, "half") == 0) config.ssaoDivisor = 2;
+            else if (std::strcmp(value, "quarter") == 0) config.ssaoDivisor = 4;
+            else ok = false;
+        }
+        else if (arg == "--ssao-samples") ok = ParseInt(value, 1, config.ssaoSamples) && config.ssaoSamples <= SSAO::kMaxSamples;
+        else if (arg == "--temporal") {
+            ok = std::strcmp(value, "on") == 0 || std::strcmp(value, "off") == 0;
+            config.temporal = std::strcmp(value, "on") == 0;
+        }
+        else if (arg == "--shadow-samples") ok = ParseInt(value, 1, config.shadowSamples) && config.shadowSamples <= 16;
+        else if (arg == "--shadow-filter") {
+            ok = std::strcmp(value, "hard") == 0 || std::strcmp(value, "pcf") == 0 || std::strcmp(value, "gather") == 0
+                || std::strcmp(value, "pcss") == 0;
+            config.shadowFilter = value;
+        }
+        else if (arg == "--out") config.outputPath = value;
+        else {
+            std::cerr << "Unknown benchmark option: " << arg << std::endl;
+            return false;
+        }
+
+        if (!ok) {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int RunBenchmark(const BenchmarkConfig& config) {
+    HeadlessContext context(config.width, config.height);
+    if (!context.isValid())
+        return 1;
+
+    std::cout << "Benchmark on " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")" << std::endl;
+
+    // Offscreen target standing in for the window's default framebuffer
+    GLuint colorBuffer, depthBuffer, outputFBO;
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, config.width, config.height);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, config.width, config.height);
+    glGenFramebuffers(1, &outputFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Benchmark framebuffer not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Same fixed state main() sets up for the interactive viewer
+    glEnable(GL_DEPTH_TEST);
+    glFrontFace(GL_CCW);
+    glDisable(GL_CULL_FACE);
+
+    int exitCode = 0;
+    {
+        Renderer benchRenderer(config.width, config.height);
+        benchRenderer.SetOutputFramebuffer(outputFBO);
+        benchRenderer.SetOcclusionCulling(config.occlusionCulling);
+        SSAOSettings ssaoSettings = benchRenderer.GetSSAOSettings();
+        ssaoSettings.resolutionDivisor = config.ssaoDivisor;
+        ssaoSettings.sampleCount = config.ssaoSamples;
+        ssaoSettings.enabled = config.ssao;
+        ssaoSettings.temporal = config.temporal;
+        benchRenderer.SetSSAOSettings(ssaoSettings);
+        ShadowSettings shadowSettings;
+        shadowSettings.enabled = config.shadows;
+        shadowSettings.temporal = config.temporal;
+        shadowSettings.sampleCount = config.shadowSamples;
+        if (config.shadowFilter == "hard") shadowSettings.filter = ShadowFilter::Hard;
+        else if (config.shadowFilter == "pcf") shadowSettings.filter = ShadowFilter::PCF;
+        else if (config.shadowFilter == "gather") shadowSettings.filter = ShadowFilter::Gather;
+        benchRenderer.SetShadowSettings(shadowSettings);
+
+        // Decode in parallel but finish before timing so every run measures fully loaded textures
+        TextureLoader textureLoader;
+        Texture diffuseTexture("Assets/Textures/StoneFloor/BC.jpg", "texture_diffuse", textureLoader);
+        Texture specularTexture("Assets/Textures/StoneFloor/AO.jpg", "texture_specular", textureLoader);
+        textureLoader.Finish();
+        std::vector<Texture> textures = { diffuseTexture, specularTexture };
+
+        Scene scene;
+        float extent = BuildScene(scene, config, textures);
+        Camera camera(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, 0.0f);
+
+        std::vector<double> frameTimes;
+        frameTimes.reserve(config.frames);
+
+        // glFinish every frame so each sample is the full CPU+GPU cost of that frame alone
+        int totalFrames = config.warmupFrames + config.frames;
+        for (int frame = 0; frame < totalFrames; ++frame) {
+            int pathFrame = frame < config.warmupFrames ? 0 : frame - config.warmupFrames;
+            camera.LookAt(CameraPathPosition(pathFrame, config.frames, extent), glm::vec3(0.0f));
+
+            auto start = std::chrono::steady_clock::now();
+            benchRenderer.RenderScene(0, 36, camera, scene);
+            glFinish();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            if (frame >= config.warmupFrames) {
+                frameTimes.push_back(ms);
+            }
+        }
+
+        benchRenderer.GetProfiler().PrintPassStats(std::cout);
+        if (WriteResults(config, frameTimes, benchRenderer.GetProfiler())) {
+            std::cout << "Wrote " << config.outputPath << std::endl;
+        }
+        else {
+            exitCode = 1;
+        }
+    }
+
+    GeometryArena::Shutdown(); // The headless context goes when this function returns
+    glDeleteFramebuffers(1, &outputFBO);
+    glDeleteRenderbuffers(1, &colorBuffer);
+    glDeleteRenderbuffers(1, &depthBuffer);
+    return exitCode;
+}
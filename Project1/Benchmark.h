@@ -0,0 +1,42 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+
+// Settings for a deterministic offscreen run of the deferred pipeline.
+// Everything that shapes the workload is here so two runs with the same config render the same frames.
+struct BenchmarkConfig {
+    int width = 1280;
+    int height = 720;
+    int warmupFrames = 30;
+    int frames = 300;
+    int cubeCount = 64;
+    int pointLightCount = 8;
+    int spotLightCount = 4;
+    unsigned int seed = 1337;
+    bool compactVertices = false; // Draw the cubes from the quantised VertexFormat::Compact arena
+    bool occlusionCulling = true; // GPU Hi-Z culling in the geometry pass
+    bool ssao = true;
+    bool shadows = true;
+    int ssaoDivisor = 2;          // SSAO resolution: 1 full, 2 half, 4 quarter
+    int ssaoSamples = 8;
+    bool temporal = true;         // Temporal accumulation of SSAO and soft shadows
+    int shadowSamples = 4;        // Soft shadow taps per pixel per frame
+    std::string shadowFilter = "pcss"; // hard, pcf, gather or pcss
+    std::string outputPath = "benchmark.json";
+};
+
+// True if the command line asks for a benchmark run instead of the interactive viewer
+bool IsBenchmarkRequested(int argc, char** argv);
+
+// Parses "--benchmark [--frames N] [--warmup N] [--cubes N] [--point-lights N] [--spot-lights N]
+// [--width N] [--height N] [--seed N] [--vertex-format full|compact] [--occlusion-culling on|off] [--ssao on|off] [--shadows on|off]
+// [--ssao-resolution full|half|quarter] [--ssao-samples N] [--temporal on|off] [--shadow-samples N]
+// [--shadow-filter hard|pcf|gather|pcss] [--out path]". Returns false on an unknown or malformed option.
+bool ParseBenchmarkArgs(int argc, char** argv, BenchmarkConfig& config);
+
+// Renders the synthetic scene along a scripted camera path and writes frame statistics as JSON.
+// Returns a process exit code.
+int RunBenchmark(const BenchmarkConfig& config);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,77 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <limits>
+
+struct AABB {
+    glm::vec3 min;
+    glm::vec3 max;
+
+    // Default-constructed boxes are empty: expanding them by anything yields that thing
+    AABB()
+        : min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max()) {}
+    AABB(const glm::vec3& min, const glm::vec3& max) : min(min), max(max) {}
+
+    bool IsEmpty() const { return min.x > max.x; }
+    glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+    glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+    float GetSurfaceArea() const {
+        glm::vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    void Expand(const glm::vec3& point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void Expand(const AABB& other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    bool Contains(const AABB& other) const {
+        return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+            max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+    }
+
+    static AABB Union(const AABB& a, const AABB& b) {
+        return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+    }
+
+    // Box enclosing this box after an affine transform (Arvo's method: no corner enumeration)
+    AABB Transformed(const glm::mat4& transform) const {
+        glm::vec3 center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+        glm::vec3 extents = GetExtents();
+        glm::vec3 newExtents(
+            std::fabs(transform[0][0]) * extents.x + std::fabs(transform[1][0]) * extents.y + std::fabs(transform[2][0]) * extents.z,
+            std::fabs(transform[0][1]) * extents.x + std::fabs(transform[1][1]) * extents.y + std::fabs(transform[2][1]) * extents.z,
+            std::fabs(transform[0][2]) * extents.x + std::fabs(transform[1][2]) * extents.y + std::fabs(transform[2][2]) * extents.z);
+        return AABB(center - newExtents, center + newExtents);
+    }
+};
+
+// Largest factor by which an affine transform stretches any direction's length (upper bound
+// for non-orthogonal axes)
+inline float MaxAxisScale(const glm::mat4& transform) {
+    return std::sqrt(std::fmax(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+        std::fmax(glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])), glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])))));
+}
+
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    // Sphere after an affine transform; non-uniform scale grows the radius by the largest axis scale
+    BoundingSphere Transformed(const glm::mat4& transform) const {
+        BoundingSphere result;
+        result.center = glm::vec3(transform * glm::vec4(center, 1.0f));
+        result.radius = radius * MaxAxisScale(transform);
+        return result;
+    }
+};
+
+#endif // BOUNDS_H
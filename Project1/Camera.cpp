@@ -1,7 +1,8 @@
-#include "camera.h"
+#include "Camera.h"
 
 Camera::Camera(glm::vec3 position, glm::vec3 up, float yaw, float pitch)
-    : position(position), worldUp(up), yaw(yaw), pitch(pitch), movementSpeed(2.5f), mouseSensitivity(0.1f) {
+    : position(position), worldUp(up), yaw(yaw), pitch(pitch), movementSpeed(2.5f), mouseSensitivity(0.1f),
+    fov(45.0f), nearPlane(0.1f), farPlane(100.0f) {
     updateCameraVectors();
 }
 
@@ -10,7 +11,7 @@ glm::mat4 Camera::GetViewMatrix() const {
 }
 
 glm::mat4 Camera::GetProjectionMatrix(float aspectRatio) const {
-    return glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f);
+    return glm::perspective(glm::radians(fov), aspectRatio, nearPlane, farPlane);
 }
 
 void Camera::ProcessKeyboardInput(float deltaTime, bool moveForward, bool moveBackward, bool moveLeft, bool moveRight) {
@@ -40,6 +41,20 @@ void Camera::ProcessMouseMovement(float xoffset, float yoffset) {
     updateCameraVectors();
 }
 
+void Camera::LookAt(const glm::vec3& position, const glm::vec3& target) {
+    this->position = position;
+    glm::vec3 direction = glm::normalize(target - position);
+    pitch = glm::degrees(asin(glm::clamp(direction.y, -1.0f, 1.0f)));
+    yaw = glm::degrees(atan2(direction.z, direction.x));
+
+    if (pitch > 89.0f)
+        pitch = 89.0f;
+    if (pitch < -89.0f)
+        pitch = -89.0f;
+
+    updateCameraVectors();
+}
+
 void Camera::updateCameraVectors() {
     glm::vec3 front;
     front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
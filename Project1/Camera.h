@@ -3,6 +3,8 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstdint>
 
 class Camera {
 public:
@@ -13,9 +15,14 @@ public:
     void ProcessKeyboardInput(float deltaTime, bool moveForward, bool moveBackward, bool moveLeft, bool moveRight);
     void ProcessMouseMovement(float xoffset, float yoffset);
 
+    // Places the camera at position looking towards target (used by scripted camera paths)
+    void LookAt(const glm::vec3& position, const glm::vec3& target);
+
     // Getter methods for position and front
     glm::vec3 GetPosition() const { return position; }
     glm::vec3 GetFront() const { return front; }
+    float GetNearPlane() const { return nearPlane; }
+    float GetFarPlane() const { return farPlane; }
 
 private:
     glm::vec3 position;
@@ -28,8 +35,41 @@ private:
     float pitch;
     float movementSpeed;
     float mouseSensitivity;
+    float fov;
+    float nearPlane;
+    float farPlane;
 
     void updateCameraVectors();
 };
 
+// The camera matrices of this frame and the one before, so temporal passes can reproject last
+// frame's results. Advance once per frame before rendering; Reset after a cut or a resize.
+struct CameraHistory {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::mat4 previousView = glm::mat4(1.0f);
+    glm::mat4 previousProjection = glm::mat4(1.0f);
+    uint32_t frameIndex = 0;  // Selects this frame's rotation of the sample sets
+    bool hasPrevious = false; // False on the first frame after a Reset: there is nothing to reproject
+
+    void Advance(const glm::mat4& newView, const glm::mat4& newProjection) {
+        hasPrevious = valid;
+        previousView = valid ? view : newView;
+        previousProjection = valid ? projection : newProjection;
+        view = newView;
+        projection = newProjection;
+        valid = true;
+        ++frameIndex;
+    }
+    void Reset() { valid = false; }
+
+    // This frame's view space to last frame's clip space
+    glm::mat4 GetViewToPreviousClip() const { return previousProjection * previousView * glm::inverse(view); }
+    // Per-frame rotation in radians; golden-ratio steps spread consecutive frames evenly
+    float GetFrameRotation() const { return std::fmod((float)(frameIndex % 4096u) * 0.61803399f, 1.0f) * 6.2831853f; }
+
+private:
+    bool valid = false;
+};
+
 #endif // CAMERA_H
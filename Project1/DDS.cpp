@@ -0,0 +1,180 @@
+#include "DDS.h"
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+
+namespace {
+
+const uint32_t kMagic = 0x20534444; // "DDS "
+
+const uint32_t kFlagCaps = 0x1;
+const uint32_t kFlagHeight = 0x2;
+const uint32_t kFlagWidth = 0x4;
+const uint32_t kFlagPixelFormat = 0x1000;
+const uint32_t kFlagMipMapCount = 0x20000;
+const uint32_t kFlagLinearSize = 0x80000;
+const uint32_t kPixelFormatFourCC = 0x4;
+const uint32_t kCapsComplex = 0x8;
+const uint32_t kCapsTexture = 0x1000;
+const uint32_t kCapsMipMap = 0x400000;
+const uint32_t kDimensionTexture2D = 3;
+
+struct PixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t bitMasks[4];
+};
+
+struct Header {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    PixelFormat pixelFormat;
+    uint32_t caps[4];
+    uint32_t reserved2;
+};
+
+struct HeaderDX10 {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+static_assert(sizeof(Header) == 124, "DDS header must be 124 bytes");
+
+constexpr uint32_t FourCC(char a, char b, char c, char d) {
+    return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+}
+
+DDSFormat FormatFromFourCC(uint32_t fourCC) {
+    switch (fourCC) {
+    case FourCC('D', 'X', 'T', '1'): return DDSFormat::BC1;
+    case FourCC('D', 'X', 'T', '5'): return DDSFormat::BC3;
+    case FourCC('A', 'T', 'I', '1'):
+    case FourCC('B', 'C', '4', 'U'): return DDSFormat::BC4;
+    case FourCC('A', 'T', 'I', '2'):
+    case FourCC('B', 'C', '5', 'U'): return DDSFormat::BC5;
+    default: return DDSFormat::Unknown;
+    }
+}
+
+} // namespace
+
+size_t DDSBlockBytes(DDSFormat format) {
+    return (format == DDSFormat::BC1 || format == DDSFormat::BC4) ? 8 : 16;
+}
+
+size_t DDSLevelSize(DDSFormat format, uint32_t width, uint32_t height) {
+    size_t blocksWide = (width + 3) / 4;
+    size_t blocksHigh = (height + 3) / 4;
+    return blocksWide * blocksHigh * DDSBlockBytes(format);
+}
+
+bool ReadDDS(const std::string& path, DDSImage& image) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint32_t magic = 0;
+    Header header;
+    file.read((char*)&magic, sizeof(magic));
+    file.read((char*)&header, sizeof(header));
+    if (!file || magic != kMagic || header.size != sizeof(Header))
+        return false;
+
+    image.format = DDSFormat::Unknown;
+    if ((header.pixelFormat.flags & kPixelFormatFourCC) && header.pixelFormat.fourCC == FourCC('D', 'X', '1', '0')) {
+        HeaderDX10 dx10;
+        file.read((char*)&dx10, sizeof(dx10));
+        if (!file || dx10.resourceDimension != kDimensionTexture2D || dx10.arraySize > 1)
+            return false;
+        switch ((DDSFormat)dx10.dxgiFormat) {
+        case DDSFormat::BC1:
+        case DDSFormat::BC3:
+        case DDSFormat::BC4:
+        case DDSFormat::BC5:
+        case DDSFormat::BC7:
+            image.format = (DDSFormat)dx10.dxgiFormat;
+            break;
+        default:
+            break;
+        }
+    }
+    else if (header.pixelFormat.flags & kPixelFormatFourCC) {
+        image.format = FormatFromFourCC(header.pixelFormat.fourCC);
+    }
+    if (image.format == DDSFormat::Unknown)
+        return false;
+
+    if (header.width == 0 || header.height == 0)
+        return false;
+
+    // A full chain ends at 1x1; anything past that is a corrupt header, not more data
+    uint32_t maxLevels = 1;
+    for (uint32_t size = std::max(header.width, header.height); size > 1; size /= 2) {
+        ++maxLevels;
+    }
+    uint32_t levelCount = (header.flags & kFlagMipMapCount) ? std::max<uint32_t>(1, header.mipMapCount) : 1;
+    levelCount = std::min(levelCount, maxLevels);
+    image.levels.clear();
+    size_t total = 0;
+    uint32_t width = header.width;
+    uint32_t height = header.height;
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        size_t size = DDSLevelSize(image.format, width, height);
+        image.levels.push_back({ width, height, total, size });
+        total += size;
+        width = std::max<uint32_t>(1, width / 2);
+        height = std::max<uint32_t>(1, height / 2);
+    }
+
+    // Check the claimed size against the file before allocating for it
+    std::streamoff dataStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff remaining = file.tellg() - dataStart;
+    file.seekg(dataStart);
+    if (!file || remaining < 0 || (unsigned long long)remaining < total)
+        return false;
+
+    image.data.resize(total);
+    file.read((char*)image.data.data(), total);
+    return (bool)file;
+}
+
+bool WriteDDS(const std::string& path, const DDSImage& image) {
+    if (image.levels.empty())
+        return false;
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.size = sizeof(Header);
+    header.flags = kFlagCaps | kFlagHeight | kFlagWidth | kFlagPixelFormat | kFlagMipMapCount | kFlagLinearSize;
+    header.width = image.levels[0].width;
+    header.height = image.levels[0].height;
+    header.pitchOrLinearSize = (uint32_t)image.levels[0].size;
+    header.mipMapCount = (uint32_t)image.levels.size();
+    header.pixelFormat.size = sizeof(PixelFormat);
+    header.pixelFormat.flags = kPixelFormatFourCC;
+    header.pixelFormat.fourCC = FourCC('D', 'X', '1', '0');
+    header.caps[0] = kCapsTexture | (image.levels.size() > 1 ? kCapsMipMap | kCapsComplex : 0);
+
+    HeaderDX10 dx10 = { (uint32_t)image.format, kDimensionTexture2D, 0, 1, 0 };
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    file.write((const char*)&kMagic, sizeof(kMagic));
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)&dx10, sizeof(dx10));
+    file.write((const char*)image.data.data(), image.data.size());
+    return (bool)file;
+}
@@ -0,0 +1,42 @@
+#ifndef DDS_H
+#define DDS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal DDS container support for block-compressed 2D textures with a full mip chain.
+// Shared by the runtime loader and the offline texture cooker, so it has no GL dependency.
+
+// DXGI_FORMAT values of the block formats we read and write
+enum class DDSFormat : uint32_t {
+    Unknown = 0,
+    BC1 = 71,  // DXGI_FORMAT_BC1_UNORM: RGB + 1-bit alpha, 8 bytes per 4x4 block
+    BC3 = 77,  // DXGI_FORMAT_BC3_UNORM: RGBA, 16 bytes per block
+    BC4 = 80,  // DXGI_FORMAT_BC4_UNORM: one channel, 8 bytes per block
+    BC5 = 83,  // DXGI_FORMAT_BC5_UNORM: two channels, 16 bytes per block
+    BC7 = 98,  // DXGI_FORMAT_BC7_UNORM: RGBA, 16 bytes per block (read only)
+};
+
+struct DDSLevel {
+    uint32_t width;
+    uint32_t height;
+    size_t offset; // Into DDSImage::data
+    size_t size;
+};
+
+struct DDSImage {
+    DDSFormat format = DDSFormat::Unknown;
+    std::vector<DDSLevel> levels; // Largest first
+    std::vector<unsigned char> data;
+};
+
+size_t DDSBlockBytes(DDSFormat format);
+size_t DDSLevelSize(DDSFormat format, uint32_t width, uint32_t height);
+
+// Parses a DX10-header or legacy FourCC (DXT1/DXT5/ATI1/ATI2/BC4U/BC5U) DDS file
+bool ReadDDS(const std::string& path, DDSImage& image);
+// Writes a DX10-header DDS; image.levels must be contiguous in image.data
+bool WriteDDS(const std::string& path, const DDSImage& image);
+
+#endif // DDS_H
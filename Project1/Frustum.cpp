@@ -0,0 +1,84 @@
+#include "Frustum.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define FRUSTUM_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+void AABB4::Set(int lane, const AABB& box) {
+    glm::vec3 center = box.GetCenter();
+    glm::vec3 extents = box.GetExtents();
+    centerX[lane] = center.x;
+    centerY[lane] = center.y;
+    centerZ[lane] = center.z;
+    extentX[lane] = extents.x;
+    extentY[lane] = extents.y;
+    extentZ[lane] = extents.z;
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+    // Gribb/Hartmann: each plane is the last row of the matrix plus or minus one of the others.
+    // glm is column-major, so row r is (m[0][r], m[1][r], m[2][r], m[3][r]).
+    for (int i = 0; i < 6; ++i) {
+        int row = i / 2;
+        float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+        float x = viewProjection[0][3] + sign * viewProjection[0][row];
+        float y = viewProjection[1][3] + sign * viewProjection[1][row];
+        float z = viewProjection[2][3] + sign * viewProjection[2][row];
+        float w = viewProjection[3][3] + sign * viewProjection[3][row];
+        float invLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+        planeX[i] = x * invLength;
+        planeY[i] = y * invLength;
+        planeZ[i] = z * invLength;
+        planeW[i] = w * invLength;
+    }
+}
+
+bool Frustum::Intersects(const AABB& box) const {
+    glm::vec3 center = box.GetCenter();
+    glm::vec3 extents = box.GetExtents();
+    for (int i = 0; i < 6; ++i) {
+        float distance = planeX[i] * center.x + planeY[i] * center.y + planeZ[i] * center.z + planeW[i];
+        float radius = std::fabs(planeX[i]) * extents.x + std::fabs(planeY[i]) * extents.y + std::fabs(planeZ[i]) * extents.z;
+        if (distance + radius < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+int Frustum::Intersects(const AABB4& boxes) const {
+#if FRUSTUM_USE_SSE
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 cx = _mm_load_ps(boxes.centerX);
+    __m128 cy = _mm_load_ps(boxes.centerY);
+    __m128 cz = _mm_load_ps(boxes.centerZ);
+    __m128 ex = _mm_load_ps(boxes.extentX);
+    __m128 ey = _mm_load_ps(boxes.extentY);
+    __m128 ez = _mm_load_ps(boxes.extentZ);
+    __m128 outside = _mm_setzero_ps();
+
+    for (int i = 0; i < 6; ++i) {
+        __m128 px = _mm_set1_ps(planeX[i]);
+        __m128 py = _mm_set1_ps(planeY[i]);
+        __m128 pz = _mm_set1_ps(planeZ[i]);
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)),
+            _mm_add_ps(_mm_mul_ps(pz, cz), _mm_set1_ps(planeW[i])));
+        // Projected half-size of the box onto the plane normal: |n| . extents
+        __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, px), ex),
+            _mm_mul_ps(_mm_andnot_ps(signMask, py), ey)), _mm_mul_ps(_mm_andnot_ps(signMask, pz), ez));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+    }
+
+    return ~_mm_movemask_ps(outside) & 0xF;
+#else
+    int mask = 0;
+    for (int lane = 0; lane < 4; ++lane) {
+        AABB box(glm::vec3(boxes.centerX[lane] - boxes.extentX[lane], boxes.centerY[lane] - boxes.extentY[lane], boxes.centerZ[lane] - boxes.extentZ[lane]),
+            glm::vec3(boxes.centerX[lane] + boxes.extentX[lane], boxes.centerY[lane] + boxes.extentY[lane], boxes.centerZ[lane] + boxes.extentZ[lane]));
+        if (Intersects(box))
+            mask |= 1 << lane;
+    }
+    return mask;
+#endif
+}
@@ -0,0 +1,36 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+#include "Bounds.h"
+
+// Four boxes in structure-of-arrays form (centre/half-extent per axis) so one SIMD
+// plane test covers all four. Callers ignore the result bits of lanes they did not fill.
+struct AABB4 {
+    alignas(16) float centerX[4];
+    alignas(16) float centerY[4];
+    alignas(16) float centerZ[4];
+    alignas(16) float extentX[4];
+    alignas(16) float extentY[4];
+    alignas(16) float extentZ[4];
+
+    void Set(int lane, const AABB& box);
+};
+
+// The six clip planes of a view-projection matrix, stored one component per array
+class Frustum {
+public:
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    bool Intersects(const AABB& box) const;
+    // Bit i of the result is set when box i is at least partially inside
+    int Intersects(const AABB4& boxes) const;
+
+private:
+    alignas(16) float planeX[6];
+    alignas(16) float planeY[6];
+    alignas(16) float planeZ[6];
+    alignas(16) float planeW[6];
+};
+
+#endif // FRUSTUM_H
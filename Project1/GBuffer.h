@@ -3,6 +3,11 @@
 
 #include <GL/glew.h>
 
+// Deferred geometry targets. Position is not stored: the lighting and SSAO passes
+// reconstruct it from the depth texture and the inverse projection.
+//   depth  - DEPTH_COMPONENT32F, sampleable
+//   normal - RG16, world-space normal octahedral-encoded into [0, 1]
+//   albedo - RGBA8, rgb = albedo, a = specular intensity
 class GBuffer {
 public:
     GBuffer(int width, int height);
@@ -11,22 +16,22 @@ public:
     void BindForWriting();
     void BindForReading();
 
-    GLuint GetPositionTexture();
-    GLuint GetNormalTexture();
-    GLuint GetAlbedoTexture();
+    GLuint GetDepthTexture() const { return depthTexture; }
+    GLuint GetNormalTexture() const { return normalTexture; }
+    GLuint GetAlbedoTexture() const { return albedoTexture; }
 
-
-    void Resize(int newWidth, int newHeight); // Add this method
+    void Resize(int newWidth, int newHeight);
 private:
     GLuint fbo;
-    GLuint positionTexture;
+    GLuint depthTexture;
     GLuint normalTexture;
     GLuint albedoTexture;
-    GLuint depthRenderBuffer;
 
     int width, height;
 
     bool Init();
+    // (Re)specifies every target at the current size; Init and Resize share it so the formats cannot drift apart
+    void AllocateTargets();
 };
 
 #endif // GBUFFER_H
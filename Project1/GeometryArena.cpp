@@ -0,0 +1,274 @@
+#include "GeometryArena.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+namespace {
+
+// Initial sizes: 32 MB of vertices and 16 MB of indices
+const GLuint kDefaultVertexCapacity = 1u << 20;
+const GLuint kDefaultIndexCapacity = 1u << 22;
+
+// Vertex stream i is fed from binding kStreamBindings[i]
+const GLuint kStreamBindings[] = { 0, 2 };
+const GLuint kInstanceBinding = 1;
+
+// The shared arenas, indexed by VertexFormat. Created by Get, emptied of GL objects by Shutdown.
+std::unique_ptr<GeometryArena> sharedArenas[2];
+
+} // namespace
+
+GeometryArena::RangeAllocator::RangeAllocator(GLuint capacity) {
+    freeBlocks[0] = capacity;
+}
+
+bool GeometryArena::RangeAllocator::Allocate(GLuint size, GLuint& offset) {
+    if (size == 0) {
+        offset = 0;
+        return true;
+    }
+
+    for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+        if (it->second < size)
+            continue;
+
+        offset = it->first;
+        GLuint remaining = it->second - size;
+        freeBlocks.erase(it);
+        if (remaining > 0) {
+            freeBlocks[offset + size] = remaining;
+        }
+        return true;
+    }
+    return false;
+}
+
+void GeometryArena::RangeAllocator::Release(GLuint offset, GLuint size) {
+    if (size == 0)
+        return;
+
+    auto next = freeBlocks.lower_bound(offset);
+
+    // Merge with the following block
+    if (next != freeBlocks.end() && offset + size == next->first) {
+        size += next->second;
+        next = freeBlocks.erase(next);
+    }
+
+    // Merge with the preceding block
+    if (next != freeBlocks.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += size;
+            return;
+        }
+    }
+
+    freeBlocks[offset] = size;
+}
+
+void GeometryArena::RangeAllocator::Grow(GLuint oldCapacity, GLuint newCapacity) {
+    Release(oldCapacity, newCapacity - oldCapacity);
+}
+
+GeometryArena::GeometryArena(VertexFormat format, GLuint vertexCapacity, GLuint indexCapacity)
+    : format(format), vertexCapacity(vertexCapacity), indexCapacity(indexCapacity),
+    vertexRanges(vertexCapacity), indexRanges(indexCapacity) {
+    if (format == VertexFormat::Compact) {
+        streamCount = 2;
+        streamStrides[0] = sizeof(CompactPosition);
+        streamStrides[1] = sizeof(CompactAttributes);
+    }
+    else {
+        streamCount = 1;
+        streamStrides[0] = sizeof(Vertex);
+    }
+    for (GLuint stream = 0; stream < streamCount; ++stream) {
+        vertexBuffers[stream] = CreateStorage((GLsizeiptr)vertexCapacity * streamStrides[stream]);
+    }
+    indexBuffer = CreateStorage((GLsizeiptr)indexCapacity * sizeof(unsigned int));
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    if (format == VertexFormat::Compact) {
+        // The fetch unit does the decoding: unorm16 positions land in [0, 1], packed normals in [-1, 1]
+        glVertexAttribFormat(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(CompactPosition, x));
+        glVertexAttribBinding(0, kStreamBindings[0]);
+        glVertexAttribFormat(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(CompactAttributes, normal));
+        glVertexAttribBinding(1, kStreamBindings[1]);
+        glVertexAttribFormat(2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(CompactAttributes, texCoords));
+        glVertexAttribBinding(2, kStreamBindings[1]);
+    }
+    else {
+        // Vertex Positions, Normals and Texture Coords from one interleaved stream
+        glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position));
+        glVertexAttribBinding(0, kStreamBindings[0]);
+        glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal));
+        glVertexAttribBinding(1, kStreamBindings[0]);
+        glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, TexCoords));
+        glVertexAttribBinding(2, kStreamBindings[0]);
+    }
+    for (GLuint stream = 0; stream < streamCount; ++stream) {
+        glBindVertexBuffer(kStreamBindings[stream], vertexBuffers[stream], 0, streamStrides[stream]);
+    }
+
+    // Per-instance model matrix (one vec4 column per location) and position dequantisation from binding 1
+    for (GLuint column = 0; column < 4; ++column) {
+        GLuint location = kInstanceMatrixLocation + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribFormat(location, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, model) + column * sizeof(glm::vec4));
+        glVertexAttribBinding(location, kInstanceBinding);
+    }
+    glEnableVertexAttribArray(kPositionOffsetLocation);
+    glVertexAttribFormat(kPositionOffsetLocation, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, positionOffset));
+    glVertexAttribBinding(kPositionOffsetLocation, kInstanceBinding);
+    glEnableVertexAttribArray(kPositionScaleLocation);
+    glVertexAttribFormat(kPositionScaleLocation, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, positionScale));
+    glVertexAttribBinding(kPositionScaleLocation, kInstanceBinding);
+    glVertexBindingDivisor(kInstanceBinding, 1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBindVertexArray(0);
+}
+
+GeometryArena::~GeometryArena() {
+    DeleteStorage();
+}
+
+GeometryArena& GeometryArena::Get(VertexFormat format) {
+    std::unique_ptr<GeometryArena>& arena = sharedArenas[(int)format];
+    if (!arena) {
+        arena.reset(new GeometryArena(format, kDefaultVertexCapacity, kDefaultIndexCapacity));
+    }
+    return *arena;
+}
+
+void GeometryArena::Shutdown() {
+    // The arenas themselves stay: meshes destroyed later still return their ranges to them
+    for (std::unique_ptr<GeometryArena>& arena : sharedArenas) {
+        if (arena) {
+            arena->DeleteStorage();
+        }
+    }
+}
+
+void GeometryArena::DeleteStorage() {
+    if (vao == 0)
+        return; // Already deleted by Shutdown, possibly with no context left to call into
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(streamCount, vertexBuffers);
+    glDeleteBuffers(1, &indexBuffer);
+    vao = 0;
+}
+
+GLuint GeometryArena::CreateStorage(GLsizeiptr size) {
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    // Through the copy target: binding GL_ELEMENT_ARRAY_BUFFER here would change whichever VAO is current
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    // Immutable size; DYNAMIC_STORAGE lets new meshes be written with glBufferSubData
+    glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return buffer;
+}
+
+std::shared_ptr<GeometryAllocation> GeometryArena::Allocate(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
+    return Allocate(vertices.data(), (GLuint)vertices.size(), indices.data(), (GLuint)indices.size());
+}
+
+std::shared_ptr<GeometryAllocation> GeometryArena::Allocate(const Vertex* vertices, GLuint vertexCount, const unsigned int* indices, GLuint indexCount) {
+    const void* streams[] = { vertices };
+    return AllocateStreams(streams, vertexCount, indices, indexCount);
+}
+
+std::shared_ptr<GeometryAllocation> GeometryArena::Allocate(const CompactPosition* positions, const CompactAttributes* attributes, GLuint vertexCount,
+    const unsigned int* indices, GLuint indexCount) {
+    const void* streams[] = { positions, attributes };
+    return AllocateStreams(streams, vertexCount, indices, indexCount);
+}
+
+std::shared_ptr<GeometryAllocation> GeometryArena::AllocateStreams(const void* const* streams, GLuint vertexCount, const unsigned int* indices, GLuint indexCount) {
+    GLuint vertexOffset = 0;
+    if (!vertexRanges.Allocate(vertexCount, vertexOffset)) {
+        GrowVertexBuffer(vertexCapacity + vertexCount);
+        vertexRanges.Allocate(vertexCount, vertexOffset);
+    }
+    GLuint indexOffset = 0;
+    if (!indexRanges.Allocate(indexCount, indexOffset)) {
+        GrowIndexBuffer(indexCapacity + indexCount);
+        indexRanges.Allocate(indexCount, indexOffset);
+    }
+
+    for (GLuint stream = 0; stream < streamCount; ++stream) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffers[stream]);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)vertexOffset * streamStrides[stream], (GLsizeiptr)vertexCount * streamStrides[stream], streams[stream]);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)indexOffset * sizeof(unsigned int), indexCount * sizeof(unsigned int), indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    // Indices stay mesh-relative; baseVertex shifts them into the shared vertex buffer
+    GeometryAllocation* allocation = new GeometryAllocation{ (GLint)vertexOffset, indexOffset, vertexCount, indexCount };
+    return std::shared_ptr<GeometryAllocation>(allocation, [this](GeometryAllocation* released) {
+        Release(*released);
+        delete released;
+    });
+}
+
+void GeometryArena::Release(const GeometryAllocation& allocation) {
+    vertexRanges.Release((GLuint)allocation.baseVertex, allocation.vertexCount);
+    indexRanges.Release(allocation.firstIndex, allocation.indexCount);
+}
+
+void GeometryArena::Bind(GLuint instanceBuffer) {
+    glBindVertexArray(vao);
+    glBindVertexBuffer(kInstanceBinding, instanceBuffer, 0, sizeof(InstanceData));
+}
+
+void GeometryArena::GrowVertexBuffer(GLuint minimumCapacity) {
+    GLuint newCapacity = std::max(vertexCapacity * 2, minimumCapacity);
+
+    glBindVertexArray(vao);
+    for (GLuint stream = 0; stream < streamCount; ++stream) {
+        GLuint newBuffer = CreateStorage((GLsizeiptr)newCapacity * streamStrides[stream]);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, vertexBuffers[stream]);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)vertexCapacity * streamStrides[stream]);
+        glDeleteBuffers(1, &vertexBuffers[stream]);
+
+        vertexBuffers[stream] = newBuffer;
+        glBindVertexBuffer(kStreamBindings[stream], newBuffer, 0, streamStrides[stream]);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindVertexArray(0);
+
+    vertexRanges.Grow(vertexCapacity, newCapacity);
+    vertexCapacity = newCapacity;
+}
+
+void GeometryArena::GrowIndexBuffer(GLuint minimumCapacity) {
+    GLuint newCapacity = std::max(indexCapacity * 2, minimumCapacity);
+    GLuint newBuffer = CreateStorage((GLsizeiptr)newCapacity * sizeof(unsigned int));
+
+    glBindBuffer(GL_COPY_READ_BUFFER, indexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)indexCapacity * sizeof(unsigned int));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &indexBuffer);
+
+    indexBuffer = newBuffer;
+    indexRanges.Grow(indexCapacity, newCapacity);
+    indexCapacity = newCapacity;
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,129 @@
+#ifndef GEOMETRYARENA_H
+#define GEOMETRYARENA_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+struct Vertex;
+
+enum class VertexFormat {
+    Full,    // Vertex: float position, normal and UV interleaved in one 32-byte stream
+    Compact, // CompactPosition and CompactAttributes: 16 bytes in two streams
+};
+
+// Position quantised to unorm16 within the mesh bounds; dequantised with the per-instance
+// positionOffset/positionScale. Depth-only passes fetch just this stream.
+struct CompactPosition {
+    uint16_t x, y, z;
+    uint16_t padding;
+};
+
+struct CompactAttributes {
+    uint32_t normal;       // snorm 10:10:10:2, GL_INT_2_10_10_10_REV
+    uint32_t texCoords;    // Two half floats
+};
+
+// Per-instance data the renderer streams for every drawn object
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec4 positionOffset; // xyz: object-space position = offset + scale * fetched position
+    glm::vec4 positionScale;
+};
+
+// Range of the arena owned by one mesh. Released back to the arena when the last
+// shared_ptr to it goes away.
+struct GeometryAllocation {
+    GLint baseVertex;
+    GLuint firstIndex;
+    GLuint vertexCount;
+    GLuint indexCount;
+};
+
+// Matches the layout glMultiDrawElementsIndirect reads
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// All mesh vertices and indices of one vertex format live in immutable vertex buffers (one per
+// stream) and one index buffer, sub-allocated per mesh and drawn through a single VAO. When a
+// buffer runs out of room it is replaced by one twice the size and the old contents are copied
+// over on the GPU.
+class GeometryArena {
+public:
+    // Attribute locations 0-2 come from the vertex streams, 3-6 are the per-instance model matrix
+    // and 7-8 the per-instance position offset and scale
+    static const GLuint kInstanceMatrixLocation = 3;
+    static const GLuint kPositionOffsetLocation = 7;
+    static const GLuint kPositionScaleLocation = 8;
+
+    GeometryArena(VertexFormat format, GLuint vertexCapacity, GLuint indexCapacity);
+    ~GeometryArena();
+
+    // The arena every Mesh of the given format allocates from; created on first use, so a GL
+    // context must exist by then
+    static GeometryArena& Get(VertexFormat format = VertexFormat::Full);
+    // Deletes the shared arenas' GL objects. Call before the context is destroyed; the arenas
+    // otherwise outlive main and would be torn down with no context. Get must not be used after.
+    static void Shutdown();
+
+    // Full format only
+    std::shared_ptr<GeometryAllocation> Allocate(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    // Uploads straight from the given memory, e.g. a mapped scene package
+    std::shared_ptr<GeometryAllocation> Allocate(const Vertex* vertices, GLuint vertexCount, const unsigned int* indices, GLuint indexCount);
+    // Compact format only
+    std::shared_ptr<GeometryAllocation> Allocate(const CompactPosition* positions, const CompactAttributes* attributes, GLuint vertexCount,
+        const unsigned int* indices, GLuint indexCount);
+
+    // Binds the arena VAO with buffer feeding the per-instance InstanceData
+    void Bind(GLuint instanceBuffer);
+
+    VertexFormat GetFormat() const { return format; }
+
+    GLuint GetVertexCapacity() const { return vertexCapacity; }
+    GLuint GetIndexCapacity() const { return indexCapacity; }
+
+private:
+    // First-fit free list over [0, capacity), merging neighbours on release
+    class RangeAllocator {
+    public:
+        explicit RangeAllocator(GLuint capacity);
+        // Returns false if no free block is large enough
+        bool Allocate(GLuint size, GLuint& offset);
+        void Release(GLuint offset, GLuint size);
+        void Grow(GLuint oldCapacity, GLuint newCapacity);
+
+    private:
+        std::map<GLuint, GLuint> freeBlocks; // offset -> size
+    };
+
+    static const GLuint kMaxStreams = 2;
+
+    VertexFormat format;
+    GLuint streamCount;
+    GLuint streamStrides[kMaxStreams];
+    GLuint vao;
+    GLuint vertexBuffers[kMaxStreams];
+    GLuint indexBuffer;
+    GLuint vertexCapacity;
+    GLuint indexCapacity;
+    RangeAllocator vertexRanges;
+    RangeAllocator indexRanges;
+
+    // streams holds streamCount arrays of vertexCount elements each
+    std::shared_ptr<GeometryAllocation> AllocateStreams(const void* const* streams, GLuint vertexCount, const unsigned int* indices, GLuint indexCount);
+    void Release(const GeometryAllocation& allocation);
+    void DeleteStorage();
+    void GrowVertexBuffer(GLuint minimumCapacity);
+    void GrowIndexBuffer(GLuint minimumCapacity);
+    static GLuint CreateStorage(GLsizeiptr size);
+};
+
+#endif // GEOMETRYARENA_H
@@ -0,0 +1,127 @@
+#include "HeadlessContext.h"
+#include <iostream>
+
+#ifndef _WIN32
+#include <EGL/eglext.h>
+#endif
+
+HeadlessContext::HeadlessContext(int width, int height)
+    : width(width), height(height), valid(false) {
+#ifdef _WIN32
+    window = nullptr;
+#else
+    display = EGL_NO_DISPLAY;
+    context = EGL_NO_CONTEXT;
+#endif
+    valid = init();
+    if (!valid) {
+        std::cerr << "Failed to create headless OpenGL context." << std::endl;
+    }
+}
+
+HeadlessContext::~HeadlessContext() {
+    cleanup();
+}
+
+bool HeadlessContext::isValid() const {
+    return valid;
+}
+
+#ifdef _WIN32
+
+bool HeadlessContext::init() {
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW." << std::endl;
+        return false;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    window = glfwCreateWindow(width, height, "Benchmark", nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Failed to create hidden GLFW window." << std::endl;
+        return false;
+    }
+
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    return initGLEW();
+}
+
+void HeadlessContext::cleanup() {
+    if (window) {
+        glfwDestroyWindow(window);
+    }
+    glfwTerminate();
+}
+
+#else
+
+bool HeadlessContext::init() {
+    // Surfaceless display: no window system, no pbuffer, just a context
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        std::cerr << "Failed to initialize EGL display." << std::endl;
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL implementation does not support desktop OpenGL." << std::endl;
+        return false;
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create EGL context (error 0x" << std::hex << eglGetError() << std::dec << ")." << std::endl;
+        return false;
+    }
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cerr << "Failed to make EGL context current." << std::endl;
+        return false;
+    }
+
+    return initGLEW();
+}
+
+void HeadlessContext::cleanup() {
+    if (display != EGL_NO_DISPLAY) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT) {
+            eglDestroyContext(display, context);
+        }
+        eglTerminate(display);
+    }
+}
+
+#endif
+
+bool HeadlessContext::initGLEW() {
+    glewExperimental = GL_TRUE;
+    GLenum result = glewInit();
+    // A GLX-built GLEW loads the GL entry points and then fails looking for an X display,
+    // which is expected under EGL.
+    if (result != GLEW_OK && result != GLEW_ERROR_NO_GLX_DISPLAY) {
+        std::cerr << "Failed to initialize GLEW." << std::endl;
+        return false;
+    }
+
+    glViewport(0, 0, width, height);
+    return true;
+}
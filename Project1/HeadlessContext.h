@@ -0,0 +1,39 @@
+#ifndef HEADLESSCONTEXT_H
+#define HEADLESSCONTEXT_H
+
+#include <GL/glew.h>
+
+#ifdef _WIN32
+#include <GLFW/glfw3.h>
+#else
+#include <EGL/egl.h>
+#endif
+
+// Offscreen OpenGL 4.5 core context with no visible surface. Uses EGL's surfaceless platform
+// where available (Mesa llvmpipe on the build machines) and a hidden GLFW window on Windows.
+// Render into an FBO; there is no default framebuffer to draw to.
+class HeadlessContext {
+public:
+    HeadlessContext(int width, int height);
+    ~HeadlessContext();
+
+    bool isValid() const;
+
+private:
+    int width;
+    int height;
+    bool valid;
+
+#ifdef _WIN32
+    GLFWwindow* window;
+#else
+    EGLDisplay display;
+    EGLContext context;
+#endif
+
+    bool init();
+    bool initGLEW();
+    void cleanup();
+};
+
+#endif // HEADLESSCONTEXT_H
@@ -1,4 +1,4 @@
-#include "inputmanager.h"
+#include "InputManager.h"
 
 InputManager::InputManager() : window(nullptr), mousePosition{ 0.0, 0.0 }, mouseDelta{ 0.0, 0.0 }, lastMousePosition{ 0.0, 0.0 } {}
 
@@ -0,0 +1,111 @@
+#include "LightBuffer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+float MaxComponent(const glm::vec3& v) {
+    return std::max(v.x, std::max(v.y, v.z));
+}
+
+// Uploads lights[range) into buffer, reallocating it first if it can no longer hold every light
+template <typename GPUType, typename SceneType>
+void UploadRange(GLuint buffer, size_t& capacity, const std::vector<SceneType>& lights, Scene::DirtyRange range,
+    std::vector<GPUType>& staging, GPUType (*pack)(const SceneType&)) {
+    if (lights.size() > capacity) {
+        capacity = std::max<size_t>(std::max<size_t>(lights.size(), capacity * 2), 64);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(GPUType), nullptr, GL_DYNAMIC_DRAW);
+        range.begin = 0;
+        range.end = lights.size();
+    }
+
+    range.end = std::min(range.end, lights.size());
+    if (range.empty())
+        return;
+
+    staging.resize(range.end - range.begin);
+    for (size_t i = range.begin; i < range.end; ++i) {
+        staging[i - range.begin] = pack(lights[i]);
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, range.begin * sizeof(GPUType), staging.size() * sizeof(GPUType), staging.data());
+}
+
+} // namespace
+
+// 5/256: the light's contribution is below what an 8-bit target can show
+const float LightBuffer::kLightCutoff = 5.0f / 256.0f;
+
+LightBuffer::LightBuffer()
+    : pointCapacity(0), spotCapacity(0), pointCount(0), spotCount(0) {
+    glGenBuffers(1, &pointBuffer);
+    glGenBuffers(1, &spotBuffer);
+
+    // Zero-capacity buffers still need storage to be bindable
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, pointBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GPUPointLight), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, spotBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GPUSpotLight), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+LightBuffer::~LightBuffer() {
+    glDeleteBuffers(1, &pointBuffer);
+    glDeleteBuffers(1, &spotBuffer);
+}
+
+void LightBuffer::Update(Scene& scene) {
+    const auto& pointLights = scene.GetPointLights();
+    const auto& spotLights = scene.GetSpotLights();
+
+    UploadRange<GPUPointLight, Scene::PointLight>(pointBuffer, pointCapacity, pointLights,
+        scene.GetPointLightDirtyRange(), pointStaging, &LightBuffer::Pack);
+    UploadRange<GPUSpotLight, Scene::SpotLight>(spotBuffer, spotCapacity, spotLights,
+        scene.GetSpotLightDirtyRange(), spotStaging, &LightBuffer::Pack);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    pointCount = pointLights.size();
+    spotCount = spotLights.size();
+    scene.ClearLightDirtyRanges();
+}
+
+void LightBuffer::Bind() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kPointLightBinding, pointBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kSpotLightBinding, spotBuffer);
+}
+
+float LightBuffer::EffectiveRadius(float constant, float linear, float quadratic, float maxIntensity) {
+    // Solve maxIntensity / (constant + linear*d + quadratic*d^2) = kLightCutoff for d
+    float c = constant - maxIntensity / kLightCutoff;
+    if (quadratic > 0.0f) {
+        return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * c)) / (2.0f * quadratic);
+    }
+    if (linear > 0.0f) {
+        return std::max(0.0f, -c / linear);
+    }
+    return 1.0e30f; // No falloff: the light reaches everything
+}
+
+GPUPointLight LightBuffer::Pack(const Scene::PointLight& light) {
+    GPUPointLight gpu;
+    gpu.positionConstant = glm::vec4(light.position, light.constant);
+    gpu.ambientLinear = glm::vec4(light.ambient, light.linear);
+    gpu.diffuseQuadratic = glm::vec4(light.diffuse, light.quadratic);
+    float maxIntensity = std::max(MaxComponent(light.ambient), std::max(MaxComponent(light.diffuse), MaxComponent(light.specular)));
+    gpu.specularRadius = glm::vec4(light.specular, EffectiveRadius(light.constant, light.linear, light.quadratic, maxIntensity));
+    return gpu;
+}
+
+GPUSpotLight LightBuffer::Pack(const Scene::SpotLight& light) {
+    GPUSpotLight gpu;
+    gpu.positionConstant = glm::vec4(light.position, light.constant);
+    gpu.directionLinear = glm::vec4(light.direction, light.linear);
+    gpu.ambientQuadratic = glm::vec4(light.ambient, light.quadratic);
+    gpu.diffuseCutOff = glm::vec4(light.diffuse, light.cutOff);
+    gpu.specularOuterCutOff = glm::vec4(light.specular, light.outerCutOff);
+    float maxIntensity = std::max(MaxComponent(light.ambient), std::max(MaxComponent(light.diffuse), MaxComponent(light.specular)));
+    gpu.range = glm::vec4(EffectiveRadius(light.constant, light.linear, light.quadratic, maxIntensity), 0.0f, 0.0f, 0.0f);
+    return gpu;
+}
@@ -0,0 +1,62 @@
+#ifndef LIGHTBUFFER_H
+#define LIGHTBUFFER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "Scene.h"
+
+// std430 layouts shared with lighting_pass.frag. Scalars ride in the w of the vec4s so
+// every field is 16-byte aligned without padding members.
+struct GPUPointLight {
+    glm::vec4 positionConstant;
+    glm::vec4 ambientLinear;
+    glm::vec4 diffuseQuadratic;
+    glm::vec4 specularRadius;
+};
+
+struct GPUSpotLight {
+    glm::vec4 positionConstant;
+    glm::vec4 directionLinear;
+    glm::vec4 ambientQuadratic;
+    glm::vec4 diffuseCutOff;
+    glm::vec4 specularOuterCutOff;
+    glm::vec4 range; // x = effective radius
+};
+
+// Mirrors the scene's point and spot lights into two shader storage buffers.
+// Only the dirty index ranges reported by Scene are re-uploaded; buffers grow geometrically.
+class LightBuffer {
+public:
+    static const GLuint kPointLightBinding = 0;
+    static const GLuint kSpotLightBinding = 1;
+
+    LightBuffer();
+    ~LightBuffer();
+
+    // Uploads whatever changed since the last call and clears the scene's dirty ranges
+    void Update(Scene& scene);
+    void Bind() const;
+
+    size_t GetPointLightCount() const { return pointCount; }
+    size_t GetSpotLightCount() const { return spotCount; }
+
+    // Distance at which the brightest channel attenuates below kLightCutoff
+    static const float kLightCutoff;
+    static float EffectiveRadius(float constant, float linear, float quadratic, float maxIntensity);
+
+private:
+    GLuint pointBuffer;
+    GLuint spotBuffer;
+    size_t pointCapacity;
+    size_t spotCapacity;
+    size_t pointCount;
+    size_t spotCount;
+    std::vector<GPUPointLight> pointStaging;
+    std::vector<GPUSpotLight> spotStaging;
+
+    static GPUPointLight Pack(const Scene::PointLight& light);
+    static GPUSpotLight Pack(const Scene::SpotLight& light);
+};
+
+#endif // LIGHTBUFFER_H
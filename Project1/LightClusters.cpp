@@ -0,0 +1,115 @@
+#include "LightClusters.h"
+#include <cmath>
+
+namespace {
+
+const unsigned int kClusterCount = LightClusters::kGridX * LightClusters::kGridY * LightClusters::kGridZ;
+const unsigned int kMaxLightIndices = kClusterCount * LightClusters::kAverageLightsPerCluster;
+
+// Local sizes of cluster_bounds.comp and cluster_cull.comp
+const unsigned int kBoundsGroupSize = 64;
+const unsigned int kCullGroupSize = 128;
+
+GLuint CreateStorageBuffer(GLsizeiptr size) {
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_COPY);
+    return buffer;
+}
+
+} // namespace
+
+LightClusters::LightClusters(int width, int height)
+    : width(width), height(height), boundsDirty(true), uniformsResolved(false), lastProjection(1.0f), sliceScale(0.0f), sliceBias(0.0f),
+    boundsShader("cluster_bounds.comp"),
+    cullShader("cluster_cull.comp") {
+    clusterBoundsBuffer = CreateStorageBuffer(kClusterCount * 2 * sizeof(glm::vec4));
+    lightGridBuffer = CreateStorageBuffer(kClusterCount * 4 * sizeof(GLuint));
+    lightIndexBuffer = CreateStorageBuffer(kMaxLightIndices * sizeof(GLuint));
+    indexCounterBuffer = CreateStorageBuffer(sizeof(GLuint));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+LightClusters::~LightClusters() {
+    glDeleteBuffers(1, &clusterBoundsBuffer);
+    glDeleteBuffers(1, &lightGridBuffer);
+    glDeleteBuffers(1, &lightIndexBuffer);
+    glDeleteBuffers(1, &indexCounterBuffer);
+}
+
+void LightClusters::Resize(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    boundsDirty = true;
+}
+
+void LightClusters::Cull(const glm::mat4& projection, const glm::mat4& view, float nearPlane, float farPlane, const LightBuffer& lights) {
+    ResolveUniforms();
+    if (boundsDirty || projection != lastProjection) {
+        BuildBounds(projection, nearPlane, farPlane);
+    }
+
+    GLuint zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, indexCounterBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    lights.Bind();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kClusterBoundsBinding, clusterBoundsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kLightGridBinding, lightGridBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kLightIndexBinding, lightIndexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kIndexCounterBinding, indexCounterBuffer);
+
+    cullShader.use();
+    cullShader.set(cullView, view);
+    cullShader.set(cullNumPointLights, (int)lights.GetPointLightCount());
+    cullShader.set(cullNumSpotLights, (int)lights.GetSpotLightCount());
+    cullShader.set(cullGridSize, GetGridSize());
+    cullShader.set(cullMaxLightIndices, kMaxLightIndices);
+    glDispatchCompute((kClusterCount + kCullGroupSize - 1) / kCullGroupSize, 1, 1);
+
+    // The lighting pass reads the grid and index list as SSBOs
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void LightClusters::Bind() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kLightGridBinding, lightGridBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kLightIndexBinding, lightIndexBuffer);
+}
+
+void LightClusters::BuildBounds(const glm::mat4& projection, float nearPlane, float farPlane) {
+    float logRatio = std::log(farPlane / nearPlane);
+    sliceScale = kGridZ / logRatio;
+    sliceBias = kGridZ * std::log(nearPlane) / logRatio;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kClusterBoundsBinding, clusterBoundsBuffer);
+    boundsShader.use();
+    boundsShader.set(boundsGridSize, GetGridSize());
+    boundsShader.set(boundsScreenSize, glm::vec2((float)width, (float)height));
+    boundsShader.set(boundsInverseProjection, glm::inverse(projection));
+    boundsShader.set(boundsZNear, nearPlane);
+    boundsShader.set(boundsZFar, farPlane);
+    glDispatchCompute((kClusterCount + kBoundsGroupSize - 1) / kBoundsGroupSize, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    lastProjection = projection;
+    boundsDirty = false;
+}
+
+void LightClusters::ResolveUniforms() {
+    if (uniformsResolved)
+        return;
+    boundsGridSize = boundsShader.getUniform<glm::uvec3>("gridSize");
+    boundsScreenSize = boundsShader.getUniform<glm::vec2>("screenSize");
+    boundsInverseProjection = boundsShader.getUniform<glm::mat4>("inverseProjection");
+    boundsZNear = boundsShader.getUniform<float>("zNear");
+    boundsZFar = boundsShader.getUniform<float>("zFar");
+
+    cullView = cullShader.getUniform<glm::mat4>("view");
+    cullNumPointLights = cullShader.getUniform<int>("numPointLights");
+    cullNumSpotLights = cullShader.getUniform<int>("numSpotLights");
+    cullGridSize = cullShader.getUniform<glm::uvec3>("gridSize");
+    cullMaxLightIndices = cullShader.getUniform<unsigned int>("maxLightIndices");
+    uniformsResolved = true;
+}
@@ -0,0 +1,73 @@
+#ifndef LIGHTCLUSTERS_H
+#define LIGHTCLUSTERS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "Shader.h"
+#include "LightBuffer.h"
+
+// Clustered light culling: the view frustum is split into a grid of froxels (screen tiles x
+// exponential depth slices) and a compute pass bins every point/spot light into the froxels its
+// effective radius touches. The lighting pass then only shades the lights of its own froxel.
+class LightClusters {
+public:
+    static const GLuint kClusterBoundsBinding = 2;
+    static const GLuint kLightGridBinding = 3;
+    static const GLuint kLightIndexBinding = 4;
+    static const GLuint kIndexCounterBinding = 5;
+
+    static const unsigned int kGridX = 16;
+    static const unsigned int kGridY = 9;
+    static const unsigned int kGridZ = 24;
+    static const unsigned int kAverageLightsPerCluster = 128;
+
+    LightClusters(int width, int height);
+    ~LightClusters();
+
+    void Resize(int newWidth, int newHeight);
+
+    // Rebuilds the froxel bounds if the projection changed, then bins the lights.
+    // The light buffer must already be up to date for this frame.
+    void Cull(const glm::mat4& projection, const glm::mat4& view, float nearPlane, float farPlane, const LightBuffer& lights);
+
+    // Binds the light grid and index list for the lighting pass
+    void Bind() const;
+
+    glm::uvec3 GetGridSize() const { return glm::uvec3(kGridX, kGridY, kGridZ); }
+    glm::vec2 GetTileSize() const { return glm::vec2((float)width / kGridX, (float)height / kGridY); }
+    // slice = floor(log(viewDepth) * scale - bias)
+    float GetSliceScale() const { return sliceScale; }
+    float GetSliceBias() const { return sliceBias; }
+
+private:
+    int width;
+    int height;
+    bool boundsDirty;
+    bool uniformsResolved;
+    glm::mat4 lastProjection;
+    float sliceScale;
+    float sliceBias;
+
+    GLuint clusterBoundsBuffer;
+    GLuint lightGridBuffer;
+    GLuint lightIndexBuffer;
+    GLuint indexCounterBuffer;
+
+    Shader boundsShader;
+    Shader cullShader;
+
+    Uniform<glm::uvec3> boundsGridSize;
+    Uniform<glm::vec2> boundsScreenSize;
+    Uniform<glm::mat4> boundsInverseProjection;
+    Uniform<float> boundsZNear, boundsZFar;
+    Uniform<glm::mat4> cullView;
+    Uniform<int> cullNumPointLights, cullNumSpotLights;
+    Uniform<glm::uvec3> cullGridSize;
+    Uniform<unsigned int> cullMaxLightIndices;
+
+    void BuildBounds(const glm::mat4& projection, float nearPlane, float farPlane);
+    // Looked up on the first cull; doing it in the constructor would wait for both programs to link
+    void ResolveUniforms();
+};
+
+#endif // LIGHTCLUSTERS_H
@@ -1,57 +1,123 @@
-#include "mesh.h"
-#include "shader.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "MeshOptimizer.h"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
 
-Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures)
-    : vertices(vertices), indices(indices), textures(textures) {
-    setupMesh();
-}
+namespace {
 
-void Mesh::setupMesh() {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+// Keeps flat meshes (a zero-extent axis) from dividing by zero when quantising
+const float kMinQuantizationExtent = 1e-6f;
 
-    glBindVertexArray(VAO);
+uint16_t QuantizeUnorm16(float value) {
+    return (uint16_t)std::lround(glm::clamp(value, 0.0f, 1.0f) * 65535.0f);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+} // namespace
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures,
+    VertexFormat format)
+    : vertices(vertices), indices(indices), textures(textures), format(format) {
+    // Imported index orders are rarely cache friendly; reordering once saves vertex shader
+    // invocations in every pass that draws the mesh
+    OptimizeMesh(this->vertices, this->indices);
+    lods = GenerateLods(this->vertices, this->indices);
+    // Compact positions are quantised relative to the bounds
+    computeBounds();
+    setupMesh(this->vertices.data(), this->vertices.size(), this->indices.data(), this->indices.size());
+}
 
-    // Vertex Positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    // Vertex Normals
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-    // Vertex Texture Coords
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+Mesh::Mesh(const Vertex* vertexData, size_t vertexCount, const unsigned int* indexData, size_t indexCount,
+    const std::vector<Texture>& textures, const AABB& bounds, const BoundingSphere& boundingSphere,
+    const std::vector<MeshLod>& lods, VertexFormat format)
+    : textures(textures), lods(lods), format(format), bounds(bounds), boundingSphere(boundingSphere) {
+    if (this->lods.empty()) {
+        this->lods.push_back({ 0, (uint32_t)indexCount, 0.0f });
+    }
+    setupMesh(vertexData, vertexCount, indexData, indexCount);
+}
 
-    glBindVertexArray(0);
+unsigned int Mesh::SelectLod(float maxError) const {
+    for (size_t lod = lods.size() - 1; lod > 0; --lod) {
+        if (lods[lod].error <= maxError)
+            return (unsigned int)lod;
+    }
+    return 0;
 }
 
-void Mesh::Draw(const Shader& shader) const {
-    unsigned int diffuseNr = 1;
-    unsigned int specularNr = 1;
+void Mesh::setupMesh(const Vertex* vertexData, size_t vertexCount, const unsigned int* indexData, size_t indexCount) {
+    GeometryArena& arena = GeometryArena::Get(format);
+    if (format == VertexFormat::Compact) {
+        positionOffset = bounds.min;
+        positionScale = glm::max(bounds.max - bounds.min, glm::vec3(kMinQuantizationExtent));
 
-    for (unsigned int i = 0; i < textures.size(); i++) {
-        std::string number;
-        std::string name = textures[i].type;
+        std::vector<CompactPosition> positions(vertexCount);
+        std::vector<CompactAttributes> attributes(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            const Vertex& vertex = vertexData[i];
+            glm::vec3 normalized = (vertex.Position - positionOffset) / positionScale;
+            positions[i] = { QuantizeUnorm16(normalized.x), QuantizeUnorm16(normalized.y), QuantizeUnorm16(normalized.z), 0 };
+            attributes[i].normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.Normal, 0.0f));
+            attributes[i].texCoords = glm::packHalf2x16(vertex.TexCoords);
+        }
+        allocation = arena.Allocate(positions.data(), attributes.data(), (GLuint)vertexCount, indexData, (GLuint)indexCount);
+    }
+    else {
+        positionOffset = glm::vec3(0.0f);
+        positionScale = glm::vec3(1.0f);
+        allocation = arena.Allocate(vertexData, (GLuint)vertexCount, indexData, (GLuint)indexCount);
+    }
 
-        if (name == "texture_diffuse")
-            number = std::to_string(diffuseNr++);
-        else if (name == "texture_specular")
-            number = std::to_string(specularNr++);
+    // The geometry pass samples one diffuse and one specular map; further textures stay unbound
+    bool hasDiffuse = false;
+    bool hasSpecular = false;
+    for (const Texture& texture : textures) {
+        int unit = -1;
+        if (texture.type == "texture_diffuse" && !hasDiffuse) {
+            unit = kDiffuseTextureUnit;
+            hasDiffuse = true;
+        }
+        else if (texture.type == "texture_specular" && !hasSpecular) {
+            unit = kSpecularTextureUnit;
+            hasSpecular = true;
+        }
+        textureUnits.push_back(unit);
+    }
+}
+
+void Mesh::computeBounds() {
+    bounds = AABB();
+    for (const auto& vertex : vertices) {
+        bounds.Expand(vertex.Position);
+    }
+
+    // Centre the sphere on the box and size it to the farthest vertex, which is tighter than the half-diagonal
+    boundingSphere.center = bounds.GetCenter();
+    float radiusSquared = 0.0f;
+    for (const auto& vertex : vertices) {
+        glm::vec3 offset = vertex.Position - boundingSphere.center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+    boundingSphere.radius = std::sqrt(radiusSquared);
+}
 
-        textures[i].bind(i);
-        shader.setInt((name + number).c_str(), i);
+void Mesh::BindTextures() const {
+    for (size_t i = 0; i < textures.size(); i++) {
+        if (textureUnits[i] >= 0) {
+            textures[i].bind((unsigned int)textureUnits[i]);
+        }
     }
 
     glActiveTexture(GL_TEXTURE0);
+}
 
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+bool Mesh::HasSameTextures(const Mesh& other) const {
+    if (textures.size() != other.textures.size())
+        return false;
+    for (size_t i = 0; i < textures.size(); i++) {
+        if (textures[i].id != other.textures[i].id || textureUnits[i] != other.textureUnits[i])
+            return false;
+    }
+    return true;
 }
@@ -3,9 +3,13 @@
 
 #include <glm/glm.hpp>
 #include <GL/glew.h>
+#include <memory>
 #include <vector>
-#include "shader.h"
-#include "texture.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "Bounds.h"
+#include "GeometryArena.h"
+#include "MeshSimplifier.h"
 
 struct Vertex {
     glm::vec3 Position;
@@ -16,16 +20,59 @@ struct Vertex {
 class Mesh {
 public:
     std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+    std::vector<unsigned int> indices; // Every LOD's index list, back to back (see GetLods)
     std::vector<Texture> textures;
 
-    Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures);
-    void Draw(const Shader& shader) const;
+    // Welds and reorders the copied vertices and indices (see meshoptimizer.h) and generates
+    // the LOD chain before uploading.
+    // VertexFormat::Compact quantises the GPU copy to half the size; vertices keeps full floats.
+    Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures,
+        VertexFormat format = VertexFormat::Full);
+    // Uploads from memory the mesh doesn't own (e.g. a mapped scene package) with precomputed bounds
+    // and LODs; an empty lods means the whole index list is the only level.
+    // The data is used as is and no CPU copy is kept, so vertices and indices stay empty.
+    Mesh(const Vertex* vertexData, size_t vertexCount, const unsigned int* indexData, size_t indexCount,
+        const std::vector<Texture>& textures, const AABB& bounds, const BoundingSphere& boundingSphere,
+        const std::vector<MeshLod>& lods, VertexFormat format = VertexFormat::Full);
+
+    // Fixed units the geometry pass's texture_diffuse and texture_specular samplers are set to once
+    static const int kDiffuseTextureUnit = 0;
+    static const int kSpecularTextureUnit = 1;
+
+    // Binds this mesh's diffuse and specular textures to their units
+    void BindTextures() const;
+    // True if both meshes bind the same textures, so their draws can share one multi-draw
+    bool HasSameTextures(const Mesh& other) const;
+
+    // Where the vertices and indices live in GeometryArena::Get(GetVertexFormat())
+    const GeometryAllocation& GetAllocation() const { return *allocation; }
+    VertexFormat GetVertexFormat() const { return format; }
+    // Maps fetched positions back to object space: offset + scale * position.
+    // Identity for VertexFormat::Full.
+    const glm::vec3& GetPositionOffset() const { return positionOffset; }
+    const glm::vec3& GetPositionScale() const { return positionScale; }
+
+    // LOD 0 is full detail; index ranges are relative to GetAllocation().firstIndex
+    const std::vector<MeshLod>& GetLods() const { return lods; }
+    // Coarsest LOD whose error is at most maxError object-space units
+    unsigned int SelectLod(float maxError) const;
+
+    // Object-space bounds, computed once from the vertex positions
+    const AABB& GetBounds() const { return bounds; }
+    const BoundingSphere& GetBoundingSphere() const { return boundingSphere; }
 
 private:
-    unsigned int VAO, VBO, EBO;
+    std::shared_ptr<GeometryAllocation> allocation; // Shared by copies, freed with the last one
+    std::vector<int> textureUnits; // Unit of each texture, -1 if the geometry pass does not sample it
+    std::vector<MeshLod> lods;
+    VertexFormat format;
+    glm::vec3 positionOffset;
+    glm::vec3 positionScale;
+    AABB bounds;
+    BoundingSphere boundingSphere;
 
-    void setupMesh();
+    void setupMesh(const Vertex* vertexData, size_t vertexCount, const unsigned int* indexData, size_t indexCount);
+    void computeBounds();
 };
 
 #endif // MESH_H
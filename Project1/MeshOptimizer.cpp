@@ -0,0 +1,318 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Forsyth's tuning: a 32-entry LRU model, a flat bonus for the triangle just drawn and a boost
+// for vertices with few triangles left so they don't get stranded
+const unsigned int kForsythCacheSize = 32;
+const float kCacheDecayPower = 1.5f;
+const float kLastTriangleScore = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+
+const uint32_t kInvalidIndex = ~0u;
+
+float VertexScore(int cachePosition, uint32_t remainingTriangles) {
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            score = kLastTriangleScore;
+        }
+        else {
+            float scaler = 1.0f / (kForsythCacheSize - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, kCacheDecayPower);
+        }
+    }
+    return score + kValenceBoostScale * std::pow((float)remainingTriangles, -kValenceBoostPower);
+}
+
+struct Float3 {
+    float x, y, z;
+
+    Float3 operator+(const Float3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+    Float3 operator-(const Float3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+    Float3 operator*(float s) const { return { x * s, y * s, z * s }; }
+};
+
+Float3 Cross(const Float3& a, const Float3& b) {
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+float Dot(const Float3& a, const Float3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+Float3 ReadPosition(const void* vertices, size_t vertexSize, uint32_t index) {
+    Float3 position;
+    std::memcpy(&position, (const unsigned char*)vertices + index * vertexSize, sizeof(position));
+    return position;
+}
+
+// FNV-1a over the raw vertex bytes
+uint64_t HashBytes(const unsigned char* bytes, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+size_t WeldVertices(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices, size_t indexCount) {
+    unsigned char* bytes = (unsigned char*)vertices;
+
+    // Open-addressed table of surviving vertex indices, at most half full
+    size_t tableSize = 1;
+    while (tableSize < vertexCount * 2)
+        tableSize *= 2;
+    std::vector<uint32_t> table(tableSize, kInvalidIndex);
+    std::vector<uint32_t> remap(vertexCount);
+
+    size_t uniqueCount = 0;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const unsigned char* vertex = bytes + v * vertexSize;
+        size_t slot = (size_t)HashBytes(vertex, vertexSize) & (tableSize - 1);
+        while (table[slot] != kInvalidIndex && std::memcmp(bytes + table[slot] * vertexSize, vertex, vertexSize) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] == kInvalidIndex) {
+            // uniqueCount <= v, so compacting in place never overwrites an unvisited vertex
+            if (uniqueCount != v)
+                std::memcpy(bytes + uniqueCount * vertexSize, vertex, vertexSize);
+            table[slot] = (uint32_t)uniqueCount++;
+        }
+        remap[v] = table[slot];
+    }
+
+    for (size_t i = 0; i < indexCount; ++i)
+        indices[i] = remap[indices[i]];
+    return uniqueCount;
+}
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Triangles using each vertex, packed per vertex; the first remaining[v] entries are still pending
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        remaining[indices[i]]++;
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int corner = 0; corner < 3; ++corner)
+            adjacency[fill[indices[t * 3 + corner]]++] = (uint32_t)t;
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        vertexScore[v] = VertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(kForsythCacheSize + 3);
+    newCache.reserve(kForsythCacheSize + 3);
+
+    uint32_t best = (uint32_t)(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+    size_t cursor = 0;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        if (best == kInvalidIndex) {
+            // Nothing in the cache touches a pending triangle: restart from the next one in input order
+            while (emitted[cursor])
+                ++cursor;
+            best = (uint32_t)cursor;
+        }
+
+        const uint32_t* triangle = indices + best * 3;
+        emitted[best] = true;
+        newCache.clear();
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t v = triangle[corner];
+            output.push_back(v);
+            newCache.push_back(v);
+
+            // Drop the triangle from the vertex's pending list
+            uint32_t* pending = adjacency.data() + adjacencyOffsets[v];
+            uint32_t* last = pending + remaining[v] - 1;
+            *std::find(pending, last + 1, best) = *last;
+            remaining[v]--;
+        }
+        for (uint32_t v : cache) {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                newCache.push_back(v);
+        }
+
+        // Rescore the cache, including the vertices it just pushed out, and pick the next triangle
+        for (size_t i = 0; i < newCache.size(); ++i) {
+            uint32_t v = newCache[i];
+            cachePosition[v] = i < kForsythCacheSize ? (int)i : -1;
+            vertexScore[v] = VertexScore(cachePosition[v], remaining[v]);
+        }
+        best = kInvalidIndex;
+        float bestScore = -1.0f;
+        for (uint32_t v : newCache) {
+            const uint32_t* pending = adjacency.data() + adjacencyOffsets[v];
+            for (uint32_t i = 0; i < remaining[v]; ++i) {
+                uint32_t t = pending[i];
+                const uint32_t* other = indices + t * 3;
+                triangleScore[t] = vertexScore[other[0]] + vertexScore[other[1]] + vertexScore[other[2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+
+        if (newCache.size() > kForsythCacheSize)
+            newCache.resize(kForsythCacheSize);
+        cache.swap(newCache);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t vertexSize, float threshold) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Clusters begin wherever the FIFO cache had to restart: all three vertices missed
+    std::vector<size_t> clusterStarts;
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    uint32_t misses = kAnalysisCacheSize + 1; // Keeps every vertex out of the cache initially
+    for (size_t t = 0; t < triangleCount; ++t) {
+        int triangleMisses = 0;
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t v = indices[t * 3 + corner];
+            if (misses - cacheTime[v] >= kAnalysisCacheSize) {
+                cacheTime[v] = misses++;
+                triangleMisses++;
+            }
+        }
+        if (triangleMisses == 3)
+            clusterStarts.push_back(t);
+    }
+    if (clusterStarts.size() < 2)
+        return;
+    clusterStarts.push_back(triangleCount);
+
+    // Area-weighted centroid and normal of each cluster and of the whole mesh
+    size_t clusterCount = clusterStarts.size() - 1;
+    std::vector<Float3> clusterCentroids(clusterCount, Float3{ 0.0f, 0.0f, 0.0f });
+    std::vector<Float3> clusterNormals(clusterCount, Float3{ 0.0f, 0.0f, 0.0f });
+    std::vector<float> clusterAreas(clusterCount, 0.0f);
+    Float3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; ++c) {
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+            Float3 a = ReadPosition(vertices, vertexSize, indices[t * 3]);
+            Float3 b = ReadPosition(vertices, vertexSize, indices[t * 3 + 1]);
+            Float3 p = ReadPosition(vertices, vertexSize, indices[t * 3 + 2]);
+            Float3 normal = Cross(b - a, p - a); // Length is twice the area
+            float area = std::sqrt(Dot(normal, normal));
+            Float3 centroid = (a + b + p) * (1.0f / 3.0f);
+
+            clusterNormals[c] = clusterNormals[c] + normal;
+            clusterCentroids[c] = clusterCentroids[c] + centroid * area;
+            clusterAreas[c] += area;
+        }
+        meshCentroid = meshCentroid + clusterCentroids[c];
+        meshArea += clusterAreas[c];
+    }
+    if (meshArea <= 0.0f)
+        return;
+    meshCentroid = meshCentroid * (1.0f / meshArea);
+
+    // Clusters facing away from the centre are on the outside and should draw first
+    std::vector<float> sortKeys(clusterCount, 0.0f);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        float normalLength = std::sqrt(Dot(clusterNormals[c], clusterNormals[c]));
+        if (clusterAreas[c] > 0.0f && normalLength > 0.0f) {
+            Float3 centroid = clusterCentroids[c] * (1.0f / clusterAreas[c]);
+            sortKeys[c] = Dot(centroid - meshCentroid, clusterNormals[c] * (1.0f / normalLength));
+        }
+    }
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+        order[c] = (uint32_t)c;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> reordered;
+    reordered.reserve(triangleCount * 3);
+    for (uint32_t c : order)
+        reordered.insert(reordered.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+
+    float before = AnalyzeVertexCache(indices, triangleCount * 3, vertexCount).acmr;
+    float after = AnalyzeVertexCache(reordered.data(), reordered.size(), vertexCount).acmr;
+    if (after <= before * threshold)
+        std::copy(reordered.begin(), reordered.end(), indices);
+}
+
+size_t OptimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices, size_t indexCount) {
+    std::vector<uint32_t> remap(vertexCount, kInvalidIndex);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t& target = remap[indices[i]];
+        if (target == kInvalidIndex)
+            target = next++;
+        indices[i] = target;
+    }
+
+    unsigned char* bytes = (unsigned char*)vertices;
+    std::vector<unsigned char> original(bytes, bytes + vertexCount * vertexSize);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (remap[v] != kInvalidIndex)
+            std::memcpy(bytes + remap[v] * vertexSize, original.data() + v * vertexSize, vertexSize);
+    }
+    return next;
+}
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize) {
+    VertexCacheStats stats = { 0.0f, 0.0f };
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return stats;
+
+    // FIFO: a vertex is resident if fewer than cacheSize misses happened since it was loaded
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t misses = cacheSize + 1;
+    uint32_t firstMiss = misses;
+    size_t uniqueVertices = 0;
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        uint32_t v = indices[i];
+        if (misses - cacheTime[v] >= cacheSize)
+            cacheTime[v] = misses++;
+        if (!referenced[v]) {
+            referenced[v] = true;
+            uniqueVertices++;
+        }
+    }
+
+    float transformed = (float)(misses - firstMiss);
+    stats.acmr = transformed / triangleCount;
+    stats.atvr = transformed / uniqueVertices;
+    return stats;
+}
@@ -0,0 +1,68 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Offline-quality reordering of indexed triangle lists, run on mesh data before it is uploaded.
+// Shared by Mesh and the scene packer, so it has no GL or glm dependency: vertices are opaque
+// fixed-size records whose first three floats are the position.
+
+// Post-transform cache behaviour of an index buffer under a FIFO cache
+struct VertexCacheStats {
+    float acmr; // Average cache miss ratio: vertex shader runs per triangle (0.5 ideal, 3 worst)
+    float atvr; // Average transformed vertex ratio: vertex shader runs per vertex (1 ideal)
+};
+
+struct MeshOptimizationStats {
+    size_t verticesBefore;
+    size_t verticesAfter;
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+const unsigned int kAnalysisCacheSize = 16;
+// Overdraw ordering may cost at most this much ACMR relative to the cache-optimised order
+const float kDefaultOverdrawThreshold = 1.05f;
+
+// Merges bitwise-identical vertices and rewrites indices to match. Returns the new vertex count;
+// surviving vertices are compacted to the front of the array.
+size_t WeldVertices(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices, size_t indexCount);
+
+// Forsyth's linear-speed vertex cache optimisation: greedily emits the triangle whose vertices
+// score best for cache position and remaining valence.
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// Splits the cache-optimised order at its cache restarts and sorts the resulting clusters
+// outside-in, so front surfaces tend to be drawn before what they hide (Sander et al. 2007).
+// Keeps the input order if the ACMR would grow by more than threshold.
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t vertexSize,
+    float threshold = kDefaultOverdrawThreshold);
+
+// Renumbers vertices in order of first use so the vertex fetch walks memory linearly.
+// Unreferenced vertices are dropped; returns the new vertex count.
+size_t OptimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices, size_t indexCount);
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+    unsigned int cacheSize = kAnalysisCacheSize);
+
+// Runs every pass above in order and shrinks vertices to the vertices still referenced
+template <typename VertexType>
+MeshOptimizationStats OptimizeMesh(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices) {
+    MeshOptimizationStats stats;
+    stats.verticesBefore = vertices.size();
+    stats.before = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+    size_t vertexCount = WeldVertices(vertices.data(), vertices.size(), sizeof(VertexType), indices.data(), indices.size());
+    OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+    OptimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, sizeof(VertexType));
+    vertexCount = OptimizeVertexFetch(vertices.data(), vertexCount, sizeof(VertexType), indices.data(), indices.size());
+    vertices.resize(vertexCount);
+
+    stats.verticesAfter = vertices.size();
+    stats.after = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+    return stats;
+}
+
+#endif // MESHOPTIMIZER_H
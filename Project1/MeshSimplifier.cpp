@@ -0,0 +1,301 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+const uint32_t kInvalidIndex = ~0u;
+
+struct Float3 {
+    float x, y, z;
+
+    Float3 operator-(const Float3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+};
+
+Float3 Cross(const Float3& a, const Float3& b) {
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+float Dot(const Float3& a, const Float3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Area-weighted sum of squared distances to a set of planes, divided by the total weight
+// when evaluated so the error reads as a mean squared distance
+struct Quadric {
+    double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+    double b0 = 0, b1 = 0, b2 = 0;
+    double c = 0;
+    double weight = 0;
+
+    void AddPlane(const Float3& normal, double distance, double planeWeight) {
+        double x = normal.x, y = normal.y, z = normal.z;
+        a00 += planeWeight * x * x;
+        a11 += planeWeight * y * y;
+        a22 += planeWeight * z * z;
+        a01 += planeWeight * x * y;
+        a02 += planeWeight * x * z;
+        a12 += planeWeight * y * z;
+        b0 += planeWeight * x * distance;
+        b1 += planeWeight * y * distance;
+        b2 += planeWeight * z * distance;
+        c += planeWeight * distance * distance;
+        weight += planeWeight;
+    }
+
+    void Add(const Quadric& o) {
+        a00 += o.a00; a11 += o.a11; a22 += o.a22;
+        a01 += o.a01; a02 += o.a02; a12 += o.a12;
+        b0 += o.b0; b1 += o.b1; b2 += o.b2;
+        c += o.c;
+        weight += o.weight;
+    }
+
+    double Error(const Float3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double error = a00 * x * x + a11 * y * y + a22 * z * z +
+            2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+            2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+    }
+};
+
+Quadric Sum(const Quadric& a, const Quadric& b) {
+    Quadric sum = a;
+    sum.Add(b);
+    return sum;
+}
+
+uint64_t EdgeKey(uint32_t from, uint32_t to) {
+    return ((uint64_t)from << 32) | to;
+}
+
+struct Collapse {
+    uint32_t source;
+    uint32_t target;
+    float cost;
+};
+
+} // namespace
+
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount,
+    size_t vertexSize, size_t targetIndexCount, float targetError, float* resultError) {
+    indexCount -= indexCount % 3;
+    std::copy(indices, indices + indexCount, destination);
+    if (resultError)
+        *resultError = 0.0f;
+    if (indexCount == 0 || vertexCount == 0)
+        return indexCount;
+
+    // Positions normalised to the unit cube so errors are relative to the mesh extent
+    std::vector<Float3> positions(vertexCount);
+    const unsigned char* bytes = (const unsigned char*)vertices;
+    Float3 minimum = { 1e30f, 1e30f, 1e30f };
+    Float3 maximum = { -1e30f, -1e30f, -1e30f };
+    for (size_t v = 0; v < vertexCount; ++v) {
+        std::memcpy(&positions[v], bytes + v * vertexSize, sizeof(Float3));
+        minimum = { std::min(minimum.x, positions[v].x), std::min(minimum.y, positions[v].y), std::min(minimum.z, positions[v].z) };
+        maximum = { std::max(maximum.x, positions[v].x), std::max(maximum.y, positions[v].y), std::max(maximum.z, positions[v].z) };
+    }
+    float extent = std::max(maximum.x - minimum.x, std::max(maximum.y - minimum.y, maximum.z - minimum.z));
+    float inverseExtent = extent > 0.0f ? 1.0f / extent : 0.0f;
+    for (Float3& position : positions)
+        position = { (position.x - minimum.x) * inverseExtent, (position.y - minimum.y) * inverseExtent, (position.z - minimum.z) * inverseExtent };
+
+    // Vertices sharing a position (seams) map to one representative that owns the quadric
+    std::vector<uint32_t> representative(vertexCount);
+    std::vector<uint32_t> wedgeCount(vertexCount, 0);
+    {
+        std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            uint32_t bits[3];
+            std::memcpy(bits, &positions[v], sizeof(bits));
+            uint64_t hash = (bits[0] * 73856093ull) ^ (bits[1] * 19349663ull) ^ (bits[2] * 83492791ull);
+            auto& bucket = buckets[hash];
+            representative[v] = v;
+            for (uint32_t other : bucket) {
+                if (std::memcmp(&positions[other], &positions[v], sizeof(Float3)) == 0) {
+                    representative[v] = other;
+                    break;
+                }
+            }
+            if (representative[v] == v)
+                bucket.push_back(v);
+            wedgeCount[representative[v]]++;
+        }
+    }
+
+    // Lock seams, and both ends of every edge without a twin in the opposite direction (borders)
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::unordered_map<uint64_t, uint32_t> directedEdges;
+        for (size_t i = 0; i < indexCount; i += 3) {
+            for (int corner = 0; corner < 3; ++corner) {
+                uint32_t from = representative[destination[i + corner]];
+                uint32_t to = representative[destination[i + (corner + 1) % 3]];
+                directedEdges[EdgeKey(from, to)]++;
+            }
+        }
+        for (const auto& edge : directedEdges) {
+            uint32_t from = (uint32_t)(edge.first >> 32);
+            uint32_t to = (uint32_t)edge.first;
+            if (directedEdges.find(EdgeKey(to, from)) == directedEdges.end()) {
+                locked[from] = true;
+                locked[to] = true;
+            }
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            if (wedgeCount[representative[v]] > 1 || locked[representative[v]])
+                locked[v] = true;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < indexCount; i += 3) {
+        const Float3& a = positions[destination[i]];
+        Float3 normal = Cross(positions[destination[i + 1]] - a, positions[destination[i + 2]] - a);
+        float length = std::sqrt(Dot(normal, normal));
+        if (length <= 0.0f)
+            continue;
+        normal = { normal.x / length, normal.y / length, normal.z / length };
+        Quadric plane;
+        plane.AddPlane(normal, -Dot(normal, a), length * 0.5f);
+        for (int corner = 0; corner < 3; ++corner)
+            quadrics[representative[destination[i + corner]]].Add(plane);
+    }
+
+    double maxCost = (double)targetError * targetError;
+    double worstCollapse = 0.0;
+    std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+    std::vector<uint32_t> vertexTriangles;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> collapseTarget(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<uint64_t> edgeKeys;
+
+    while (indexCount > targetIndexCount) {
+        size_t triangleCount = indexCount / 3;
+
+        // Triangles around each vertex, for the flip test
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (size_t i = 0; i < indexCount; ++i)
+            triangleOffsets[destination[i] + 1]++;
+        for (size_t v = 0; v < vertexCount; ++v)
+            triangleOffsets[v + 1] += triangleOffsets[v];
+        vertexTriangles.resize(indexCount);
+        std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (size_t i = 0; i < indexCount; ++i)
+            vertexTriangles[fill[destination[i]]++] = (uint32_t)(i / 3);
+
+        edgeKeys.clear();
+        for (size_t i = 0; i < indexCount; i += 3) {
+            for (int corner = 0; corner < 3; ++corner)
+                edgeKeys.push_back(EdgeKey(destination[i + corner], destination[i + (corner + 1) % 3]));
+        }
+        std::sort(edgeKeys.begin(), edgeKeys.end());
+
+        // Cheapest collapse per source vertex; the source moves onto the target's position
+        collapses.clear();
+        std::fill(collapseTarget.begin(), collapseTarget.end(), kInvalidIndex);
+        std::vector<float> bestCost(vertexCount, 1e30f);
+        for (uint64_t key : edgeKeys) {
+            uint32_t a = (uint32_t)(key >> 32);
+            uint32_t b = (uint32_t)key;
+            for (int direction = 0; direction < 2; ++direction) {
+                uint32_t source = direction == 0 ? a : b;
+                uint32_t target = direction == 0 ? b : a;
+                if (locked[source])
+                    continue;
+                // A seam target has several vertices; only collapse onto the one both triangles of the edge use
+                if (wedgeCount[representative[target]] > 1 &&
+                    !std::binary_search(edgeKeys.begin(), edgeKeys.end(), EdgeKey(target, source)))
+                    continue;
+
+                float cost = (float)Sum(quadrics[representative[source]], quadrics[representative[target]]).Error(positions[target]);
+                if (cost < bestCost[source]) {
+                    bestCost[source] = cost;
+                    collapseTarget[source] = target;
+                }
+            }
+        }
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            if (collapseTarget[v] != kInvalidIndex && bestCost[v] <= maxCost)
+                collapses.push_back({ v, collapseTarget[v], bestCost[v] });
+        }
+        if (collapses.empty())
+            break;
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // Apply independent collapses cheapest first until the target is in sight
+        for (uint32_t v = 0; v < vertexCount; ++v)
+            collapseTarget[v] = v;
+        std::fill(touched.begin(), touched.end(), false);
+        size_t removedTriangles = 0;
+        size_t applied = 0;
+        for (const Collapse& collapse : collapses) {
+            if ((triangleCount - removedTriangles) * 3 <= targetIndexCount)
+                break;
+            uint32_t source = collapse.source;
+            uint32_t target = collapse.target;
+            if (touched[source] || touched[target])
+                continue;
+
+            // Reject the collapse if any remaining triangle around source would flip over
+            bool flips = false;
+            size_t collapsedTriangles = 0;
+            for (uint32_t t = triangleOffsets[source]; t < triangleOffsets[source + 1] && !flips; ++t) {
+                const uint32_t* triangle = destination + vertexTriangles[t] * 3;
+                if (triangle[0] == target || triangle[1] == target || triangle[2] == target) {
+                    collapsedTriangles++;
+                    continue;
+                }
+                Float3 corners[3];
+                Float3 moved[3];
+                for (int corner = 0; corner < 3; ++corner) {
+                    corners[corner] = positions[triangle[corner]];
+                    moved[corner] = triangle[corner] == source ? positions[target] : corners[corner];
+                }
+                Float3 before = Cross(corners[1] - corners[0], corners[2] - corners[0]);
+                Float3 after = Cross(moved[1] - moved[0], moved[2] - moved[0]);
+                if (Dot(before, after) <= 0.0f)
+                    flips = true;
+            }
+            if (flips)
+                continue;
+
+            collapseTarget[source] = target;
+            quadrics[representative[target]].Add(quadrics[representative[source]]);
+            worstCollapse = std::max(worstCollapse, (double)collapse.cost);
+            removedTriangles += collapsedTriangles;
+            applied++;
+
+            // Everything in source's fan changes; keep later collapses this pass away from it
+            for (uint32_t t = triangleOffsets[source]; t < triangleOffsets[source + 1]; ++t) {
+                const uint32_t* triangle = destination + vertexTriangles[t] * 3;
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+            }
+        }
+        if (applied == 0)
+            break;
+
+        // Rewrite the indices, dropping triangles that collapsed to a line
+        size_t written = 0;
+        for (size_t i = 0; i < indexCount; i += 3) {
+            uint32_t a = collapseTarget[destination[i]];
+            uint32_t b = collapseTarget[destination[i + 1]];
+            uint32_t c = collapseTarget[destination[i + 2]];
+            if (representative[a] == representative[b] || representative[b] == representative[c] || representative[a] == representative[c])
+                continue;
+            destination[written++] = a;
+            destination[written++] = b;
+            destination[written++] = c;
+        }
+        indexCount = written;
+    }
+
+    if (resultError)
+        *resultError = (float)std::sqrt(worstCollapse) * extent;
+    return indexCount;
+}
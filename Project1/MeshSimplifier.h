@@ -0,0 +1,64 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MeshOptimizer.h"
+
+// Level-of-detail index buffers built by quadric-error edge collapse. Like the optimiser this is
+// shared with the scene packer, so vertices are opaque records whose first three floats are the
+// position. Every LOD reuses the mesh's vertex buffer; only the index list gets shorter.
+
+// One level of detail: a range of the mesh's index buffer
+struct MeshLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error; // Object-space distance the surface may have moved from LOD 0
+};
+
+const unsigned int kMaxMeshLods = 4;
+// Each LOD aims for this fraction of the previous one's triangles...
+const float kLodReduction = 0.5f;
+// ...but may not deviate more than this, relative to the mesh extent
+const float kLodMaxRelativeError = 0.1f;
+
+// Collapses edges cheapest first until at most targetIndexCount indices remain or the next
+// collapse would move the surface by more than targetError (relative to the mesh extent).
+// Vertices on open borders and UV/normal seams (several vertices sharing a position) never
+// move, so silhouettes and texture seams survive. Writes the result to destination, which must
+// hold indexCount indices, and returns its length. resultError receives the object-space error.
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount,
+    size_t vertexSize, size_t targetIndexCount, float targetError, float* resultError);
+
+// Appends successively simplified, cache-optimised copies of the index list to indices and
+// returns the LOD table, LOD 0 being the original list. Stops early once simplification no
+// longer pays for itself.
+template <typename VertexType>
+std::vector<MeshLod> GenerateLods(const std::vector<VertexType>& vertices, std::vector<uint32_t>& indices,
+    unsigned int maxLods = kMaxMeshLods) {
+    std::vector<MeshLod> lods;
+    lods.push_back({ 0, (uint32_t)indices.size(), 0.0f });
+
+    std::vector<uint32_t> simplified(indices.size());
+    for (unsigned int level = 1; level < maxLods; ++level) {
+        MeshLod source = lods.back();
+        size_t target = (size_t)(source.indexCount / 3 * kLodReduction) * 3;
+        float error = 0.0f;
+        size_t count = SimplifyMesh(simplified.data(), indices.data() + source.firstIndex, source.indexCount,
+            vertices.data(), vertices.size(), sizeof(VertexType), target, kLodMaxRelativeError, &error);
+
+        // Less than a fifth fewer triangles isn't worth the extra indices
+        if (count == 0 || count * 5 > (size_t)source.indexCount * 4)
+            break;
+
+        OptimizeVertexCache(simplified.data(), count, vertices.size());
+        // Errors accumulate because each level is simplified from the previous one
+        MeshLod lod = { (uint32_t)indices.size(), (uint32_t)count, source.error + error };
+        indices.insert(indices.end(), simplified.begin(), simplified.begin() + count);
+        lods.push_back(lod);
+    }
+    return lods;
+}
+
+#endif // MESHSIMPLIFIER_H
@@ -0,0 +1,171 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+
+namespace {
+
+// Local sizes of hiz_build.comp and hiz_cull.comp
+const int kBuildGroupSize = 8;
+const GLuint kCullGroupSize = 64;
+
+} // namespace
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+    : width(width), height(height), pyramid(0), pyramidWidth(0), pyramidHeight(0), pyramidLevels(0),
+    hasPyramid(false), uniformsResolved(false), pyramidViewProjection(1.0f), instanceCount(0), commandCount(0),
+    buildShader("hiz_build.comp"),
+    cullShader("hiz_cull.comp") {
+    glGenBuffers(1, &inputInstanceBuffer);
+    glGenBuffers(1, &cullInstanceBuffer);
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &outputInstanceBuffer);
+    glGenBuffers(1, &retestBuffer);
+    CreatePyramid();
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    glDeleteTextures(1, &pyramid);
+    glDeleteBuffers(1, &inputInstanceBuffer);
+    glDeleteBuffers(1, &cullInstanceBuffer);
+    glDeleteBuffers(1, &commandBuffer);
+    glDeleteBuffers(1, &outputInstanceBuffer);
+    glDeleteBuffers(1, &retestBuffer);
+}
+
+void OcclusionCuller::Resize(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    glDeleteTextures(1, &pyramid);
+    CreatePyramid();
+}
+
+void OcclusionCuller::CreatePyramid() {
+    // Level 0 is half the depth resolution, rounded up so every depth texel has a parent
+    pyramidWidth = std::max(1, (width + 1) / 2);
+    pyramidHeight = std::max(1, (height + 1) / 2);
+    pyramidLevels = 1;
+    for (int size = std::max(pyramidWidth, pyramidHeight); size > 1; size /= 2) {
+        ++pyramidLevels;
+    }
+
+    glGenTextures(1, &pyramid);
+    glBindTexture(GL_TEXTURE_2D, pyramid);
+    glTexStorage2D(GL_TEXTURE_2D, pyramidLevels, GL_R32F, pyramidWidth, pyramidHeight);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    hasPyramid = false;
+}
+
+void OcclusionCuller::Upload(const std::vector<InstanceData>& instances, const std::vector<CullInstance>& cullInstances,
+    const std::vector<DrawElementsIndirectCommand>& commands) {
+    instanceCount = (GLuint)instances.size();
+    commandCount = (GLuint)commands.size();
+
+    // Both phases start empty; phase 2 writes its instances after all of phase 1's slots
+    commandStaging.resize(commands.size() * 2);
+    for (size_t i = 0; i < commands.size(); ++i) {
+        commandStaging[i] = commands[i];
+        commandStaging[i].instanceCount = 0;
+        commandStaging[commands.size() + i] = commandStaging[i];
+        commandStaging[commands.size() + i].baseInstance += instanceCount;
+    }
+
+    // Orphaned every frame like the renderer's own streaming buffers
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, inputInstanceBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, instances.size() * sizeof(InstanceData), instances.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cullInstanceBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, cullInstances.size() * sizeof(CullInstance), cullInstances.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, commandStaging.size() * sizeof(DrawElementsIndirectCommand), commandStaging.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, outputInstanceBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * instances.size() * sizeof(InstanceData), nullptr, GL_STREAM_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, retestBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, instances.size() * sizeof(GLuint), nullptr, GL_STREAM_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void OcclusionCuller::CullFirstPhase() {
+    Cull(false);
+}
+
+void OcclusionCuller::CullSecondPhase() {
+    Cull(true);
+}
+
+void OcclusionCuller::BuildPyramid(GLuint depthTexture, const glm::mat4& viewProjection) {
+    ResolveUniforms();
+    buildShader.use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+
+    // Each level takes the max of the 2x2 texels under it; level 0 reads the depth texture itself
+    glm::ivec2 sourceSize(width, height);
+    glm::ivec2 levelSize(pyramidWidth, pyramidHeight);
+    for (int level = 0; level < pyramidLevels; ++level) {
+        buildShader.set(buildFromDepth, level == 0);
+        buildShader.set(buildSourceSize, sourceSize);
+        if (level > 0) {
+            glBindImageTexture(1, pyramid, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        }
+        glBindImageTexture(0, pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((levelSize.x + kBuildGroupSize - 1) / kBuildGroupSize, (levelSize.y + kBuildGroupSize - 1) / kBuildGroupSize, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        sourceSize = levelSize;
+        levelSize = glm::ivec2(std::max(1, (levelSize.x + 1) / 2), std::max(1, (levelSize.y + 1) / 2));
+    }
+
+    // The cull shader samples the pyramid with texelFetch
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    pyramidViewProjection = viewProjection;
+    hasPyramid = true;
+}
+
+void OcclusionCuller::Cull(bool secondPhase) {
+    if (instanceCount == 0)
+        return;
+    ResolveUniforms();
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kInstanceInputBinding, inputInstanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCullInstanceBinding, cullInstanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kInstanceOutputBinding, outputInstanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kRetestBinding, retestBuffer);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, pyramid);
+
+    cullShader.use();
+    cullShader.set(cullInstanceCount, instanceCount);
+    cullShader.set(cullCommandOffset, secondPhase ? commandCount : 0u);
+    cullShader.set(cullHasPyramid, hasPyramid);
+    cullShader.set(cullSecondPhase, secondPhase);
+    cullShader.set(cullViewProjection, pyramidViewProjection);
+    cullShader.set(cullDepthSize, glm::vec2((float)width, (float)height));
+    glDispatchCompute((instanceCount + kCullGroupSize - 1) / kCullGroupSize, 1, 1);
+
+    // The counts feed the indirect draws, the compacted instances the instanced attributes,
+    // and phase 1's retest flags the second dispatch
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void OcclusionCuller::ResolveUniforms() {
+    if (uniformsResolved)
+        return;
+    buildFromDepth = buildShader.getUniform<bool>("fromDepth");
+    buildSourceSize = buildShader.getUniform<glm::ivec2>("sourceSize");
+    cullInstanceCount = cullShader.getUniform<unsigned int>("instanceCount");
+    cullCommandOffset = cullShader.getUniform<unsigned int>("commandOffset");
+    cullHasPyramid = cullShader.getUniform<bool>("hasPyramid");
+    cullSecondPhase = cullShader.getUniform<bool>("secondPhase");
+    cullViewProjection = cullShader.getUniform<glm::mat4>("viewProjection");
+    cullDepthSize = cullShader.getUniform<glm::vec2>("depthSize");
+
+    buildShader.use();
+    buildShader.setInt("depth", 0);
+    cullShader.use();
+    cullShader.setInt("hiZ", 0);
+    glUseProgram(0);
+    uniformsResolved = true;
+}
@@ -0,0 +1,93 @@
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "Shader.h"
+#include "GeometryArena.h"
+
+// World bounds of one instance and the draw command it belongs to; std430 mirror in hiz_cull.comp
+struct CullInstance {
+    glm::vec4 boundsMin;
+    glm::vec4 boundsMax;
+    glm::uvec4 command; // x = index of the instance's command in the pass's command list
+};
+
+// GPU occlusion culling against a hierarchical-Z pyramid: an R32F mip chain where each texel
+// holds the farthest depth of the texels below it. A frame culls in two phases over the same
+// CPU-built command list:
+//   1. every instance is tested against the pyramid of the previous frame and the survivors drawn
+//   2. the pyramid is rebuilt from that depth and only the instances phase 1 rejected are re-tested,
+//      so whatever the stale pyramid hid by mistake is drawn this frame instead of popping in late.
+// The cull shader compacts survivors into an instance buffer and counts them into the commands'
+// instanceCount. Commands keep their CPU order, so material and vertex format runs are unchanged.
+class OcclusionCuller {
+public:
+    static const GLuint kInstanceInputBinding = 6;
+    static const GLuint kCullInstanceBinding = 7;
+    static const GLuint kCommandBinding = 8;
+    static const GLuint kInstanceOutputBinding = 9;
+    static const GLuint kRetestBinding = 10;
+
+    OcclusionCuller(int width, int height);
+    ~OcclusionCuller();
+
+    // Reallocates the pyramid; the next frame culls phase 1 without occlusion
+    void Resize(int newWidth, int newHeight);
+
+    // Uploads one pass's instances. Phase 1 draws commands [0, count) of GetCommandBuffer() and
+    // phase 2 draws [count, 2 * count); both read instances from GetInstanceBuffer().
+    void Upload(const std::vector<InstanceData>& instances, const std::vector<CullInstance>& cullInstances,
+        const std::vector<DrawElementsIndirectCommand>& commands);
+
+    // Tests every instance against the current pyramid, or passes them all if there is none yet
+    void CullFirstPhase();
+    // Rebuilds the pyramid from depth rendered with viewProjection
+    void BuildPyramid(GLuint depthTexture, const glm::mat4& viewProjection);
+    // Re-tests the instances CullFirstPhase rejected against the rebuilt pyramid
+    void CullSecondPhase();
+
+    GLuint GetCommandBuffer() const { return commandBuffer; }
+    GLuint GetInstanceBuffer() const { return outputInstanceBuffer; }
+
+private:
+    int width;
+    int height;
+
+    GLuint pyramid;
+    int pyramidWidth;
+    int pyramidHeight;
+    int pyramidLevels;
+    bool hasPyramid;
+    bool uniformsResolved;
+    glm::mat4 pyramidViewProjection; // Transform the pyramid's depth was rendered with
+
+    GLuint inputInstanceBuffer;
+    GLuint cullInstanceBuffer;
+    GLuint commandBuffer;
+    GLuint outputInstanceBuffer;
+    GLuint retestBuffer;
+    GLuint instanceCount;
+    GLuint commandCount;
+    std::vector<DrawElementsIndirectCommand> commandStaging;
+
+    Shader buildShader;
+    Shader cullShader;
+
+    Uniform<bool> buildFromDepth;
+    Uniform<glm::ivec2> buildSourceSize;
+    Uniform<unsigned int> cullInstanceCount;
+    Uniform<unsigned int> cullCommandOffset;
+    Uniform<bool> cullHasPyramid;
+    Uniform<bool> cullSecondPhase;
+    Uniform<glm::mat4> cullViewProjection;
+    Uniform<glm::vec2> cullDepthSize;
+
+    void CreatePyramid();
+    void Cull(bool secondPhase);
+    // Deferred to first use so constructing the culler does not wait for its programs to link
+    void ResolveUniforms();
+};
+
+#endif // OCCLUSIONCULLER_H
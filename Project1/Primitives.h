@@ -0,0 +1,11 @@
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include <vector>
+#include "Mesh.h"
+
+// Unit cube centred on the origin, one quad per face so each face gets its own normal and UVs
+extern const std::vector<Vertex> cubeVertices;
+extern const std::vector<unsigned int> cubeIndices;
+
+#endif // PRIMITIVES_H
@@ -0,0 +1,246 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+void PushSample(std::vector<float>& window, size_t& next, size_t capacity, float value) {
+    if (window.size() < capacity) {
+        window.push_back(value);
+    }
+    else {
+        window[next] = value;
+    }
+    next = (next + 1) % capacity;
+}
+
+double Percentile(std::vector<float> samples, double p) {
+    if (samples.empty())
+        return 0.0;
+    size_t index = (size_t)(p * (samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+void WriteJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\')
+            out << '\\';
+        out << *c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+Profiler::Profiler() : frameIndex(0), inFrame(false), traceNext(0), epoch(std::chrono::steady_clock::now()) {}
+
+Profiler::~Profiler() {
+    for (auto& slot : frames) {
+        if (!slot.queries.empty()) {
+            glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data());
+        }
+    }
+}
+
+double Profiler::NowMicroseconds() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+GLuint Profiler::AcquireQuery(FrameSlot& slot) {
+    if (slot.queriesUsed == slot.queries.size()) {
+        GLuint query;
+        glGenQueries(1, &query);
+        slot.queries.push_back(query);
+    }
+    return slot.queries[slot.queriesUsed++];
+}
+
+void Profiler::BeginFrame() {
+    ++frameIndex;
+    FrameSlot& slot = frames[frameIndex % kFrameLatency];
+
+    // The slot's previous frame is kFrameLatency frames old; if the GPU still hasn't finished it
+    // we drop its GPU timings rather than block on the query results.
+    if (slot.pending) {
+        TryResolve(slot, true);
+    }
+
+    slot.frameIndex = frameIndex;
+    slot.scopes.clear();
+    slot.queriesUsed = 0;
+
+    // Align the GPU timestamp domain with our CPU clock for the trace
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    slot.gpuToCpuOffset = NowMicroseconds() - gpuNow / 1000.0;
+
+    openScopes.clear();
+    inFrame = true;
+    BeginScope("Frame");
+}
+
+void Profiler::EndFrame() {
+    if (!inFrame)
+        return;
+
+    while (!openScopes.empty()) {
+        EndScope();
+    }
+    inFrame = false;
+    frames[frameIndex % kFrameLatency].pending = true;
+
+    // Resolve older frames oldest-first, stopping at the first one the GPU hasn't finished yet
+    for (int i = 1; i < kFrameLatency; ++i) {
+        FrameSlot& slot = frames[(frameIndex + i) % kFrameLatency];
+        if (slot.pending && !TryResolve(slot, false))
+            break;
+    }
+}
+
+void Profiler::BeginScope(const char* name) {
+    if (!inFrame)
+        return;
+
+    FrameSlot& slot = frames[frameIndex % kFrameLatency];
+    ScopeRecord scope;
+    scope.name = name;
+    scope.depth = (int)openScopes.size();
+    scope.startQuery = AcquireQuery(slot);
+    scope.endQuery = 0;
+    glQueryCounter(scope.startQuery, GL_TIMESTAMP);
+    scope.cpuStart = NowMicroseconds();
+    scope.cpuEnd = scope.cpuStart;
+
+    openScopes.push_back(slot.scopes.size());
+    slot.scopes.push_back(scope);
+}
+
+void Profiler::EndScope() {
+    if (!inFrame || openScopes.empty())
+        return;
+
+    FrameSlot& slot = frames[frameIndex % kFrameLatency];
+    ScopeRecord& scope = slot.scopes[openScopes.back()];
+    openScopes.pop_back();
+
+    scope.cpuEnd = NowMicroseconds();
+    scope.endQuery = AcquireQuery(slot);
+    glQueryCounter(scope.endQuery, GL_TIMESTAMP);
+}
+
+bool Profiler::TryResolve(FrameSlot& slot, bool force) {
+    bool gpuValid = false;
+    if (slot.queriesUsed > 0) {
+        // Timestamps complete in submission order, so the last one tells us about all of them
+        GLuint available = 0;
+        glGetQueryObjectuiv(slot.queries[slot.queriesUsed - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available && !force)
+            return false;
+        gpuValid = available != 0;
+    }
+
+    std::vector<TraceEvent> events;
+    events.reserve(slot.scopes.size() * 2);
+    for (const auto& scope : slot.scopes) {
+        double cpuMs = (scope.cpuEnd - scope.cpuStart) / 1000.0;
+        double gpuMs = -1.0;
+        events.push_back({ scope.name, scope.depth, false, scope.cpuStart, scope.cpuEnd - scope.cpuStart });
+
+        if (gpuValid && scope.endQuery != 0) {
+            GLuint64 gpuStart = 0, gpuEnd = 0;
+            glGetQueryObjectui64v(scope.startQuery, GL_QUERY_RESULT, &gpuStart);
+            glGetQueryObjectui64v(scope.endQuery, GL_QUERY_RESULT, &gpuEnd);
+            gpuMs = (gpuEnd - gpuStart) / 1.0e6;
+            events.push_back({ scope.name, scope.depth, true, gpuStart / 1000.0 + slot.gpuToCpuOffset, (gpuEnd - gpuStart) / 1000.0 });
+        }
+
+        Record(scope, cpuMs, gpuMs);
+    }
+
+    if (traceFrames.size() < kTraceFrames) {
+        traceFrames.push_back(std::move(events));
+    }
+    else {
+        traceFrames[traceNext] = std::move(events);
+    }
+    traceNext = (traceNext + 1) % kTraceFrames;
+
+    slot.pending = false;
+    return true;
+}
+
+void Profiler::Record(const ScopeRecord& scope, double cpuMs, double gpuMs) {
+    auto it = historyIndex.find(scope.name);
+    if (it == historyIndex.end()) {
+        it = historyIndex.emplace(scope.name, history.size()).first;
+        history.push_back(ScopeHistory());
+        history.back().name = scope.name;
+    }
+
+    ScopeHistory& entry = history[it->second];
+    PushSample(entry.cpuMs, entry.cpuNext, kHistorySize, (float)cpuMs);
+    if (gpuMs >= 0.0) {
+        PushSample(entry.gpuMs, entry.gpuNext, kHistorySize, (float)gpuMs);
+    }
+}
+
+std::vector<Profiler::PassStats> Profiler::GetPassStats() const {
+    std::vector<PassStats> stats;
+    stats.reserve(history.size());
+    for (const auto& entry : history) {
+        PassStats s;
+        s.name = entry.name;
+        s.samples = entry.cpuMs.size();
+        s.cpuP50 = Percentile(entry.cpuMs, 0.50);
+        s.cpuP95 = Percentile(entry.cpuMs, 0.95);
+        s.cpuP99 = Percentile(entry.cpuMs, 0.99);
+        s.gpuP50 = Percentile(entry.gpuMs, 0.50);
+        s.gpuP95 = Percentile(entry.gpuMs, 0.95);
+        s.gpuP99 = Percentile(entry.gpuMs, 0.99);
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+void Profiler::PrintPassStats(std::ostream& out) const {
+    out << std::left << std::setw(16) << "pass"
+        << std::right << std::setw(10) << "cpu p50" << std::setw(10) << "cpu p95" << std::setw(10) << "cpu p99"
+        << std::setw(10) << "gpu p50" << std::setw(10) << "gpu p95" << std::setw(10) << "gpu p99" << "  (ms)" << std::endl;
+    out << std::fixed << std::setprecision(3);
+    for (const auto& s : GetPassStats()) {
+        out << std::left << std::setw(16) << s.name
+            << std::right << std::setw(10) << s.cpuP50 << std::setw(10) << s.cpuP95 << std::setw(10) << s.cpuP99
+            << std::setw(10) << s.gpuP50 << std::setw(10) << s.gpuP95 << std::setw(10) << s.gpuP99 << std::endl;
+    }
+    out.unsetf(std::ios::floatfield);
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open profiler trace for writing: " << path << std::endl;
+        return false;
+    }
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+    size_t start = traceFrames.size() < kTraceFrames ? 0 : traceNext;
+    for (size_t i = 0; i < traceFrames.size(); ++i) {
+        for (const auto& event : traceFrames[(start + i) % traceFrames.size()]) {
+            file << ",\n{\"name\":";
+            WriteJsonString(file, event.name);
+            file << ",\"cat\":\"" << (event.gpu ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (event.gpu ? 2 : 1)
+                << ",\"ts\":" << event.start << ",\"dur\":" << event.duration
+                << ",\"args\":{\"depth\":" << event.depth << "}}";
+        }
+    }
+    file << "\n]}\n";
+    return true;
+}
@@ -0,0 +1,106 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <GL/glew.h>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Frame profiler that brackets render passes with CPU timers and GL timestamp queries.
+// Query results are read back kFrameLatency frames later so the CPU never waits on the GPU.
+class Profiler {
+public:
+    struct PassStats {
+        std::string name;
+        size_t samples;
+        double cpuP50, cpuP95, cpuP99; // milliseconds
+        double gpuP50, gpuP95, gpuP99; // milliseconds
+    };
+
+    Profiler();
+    ~Profiler();
+
+    void BeginFrame();
+    void EndFrame();
+
+    void BeginScope(const char* name);
+    void EndScope();
+
+    // Rolling percentiles over the last kHistorySize resolved samples of every scope
+    std::vector<PassStats> GetPassStats() const;
+    void PrintPassStats(std::ostream& out) const;
+
+    // Writes the last kTraceFrames resolved frames in Chrome/Perfetto trace event format
+    bool WriteChromeTrace(const std::string& path) const;
+
+private:
+    static const int kFrameLatency = 4;
+    static const size_t kHistorySize = 256;
+    static const size_t kTraceFrames = 300;
+
+    struct ScopeRecord {
+        const char* name;
+        int depth;
+        double cpuStart, cpuEnd; // microseconds since profiler creation
+        GLuint startQuery, endQuery;
+    };
+
+    struct FrameSlot {
+        uint64_t frameIndex = 0;
+        double gpuToCpuOffset = 0.0; // microseconds
+        std::vector<ScopeRecord> scopes;
+        std::vector<GLuint> queries; // pool reused every time the slot comes round
+        size_t queriesUsed = 0;
+        bool pending = false;
+    };
+
+    struct TraceEvent {
+        const char* name;
+        int depth;
+        bool gpu;
+        double start, duration; // microseconds
+    };
+
+    struct ScopeHistory {
+        std::string name;
+        std::vector<float> cpuMs;
+        std::vector<float> gpuMs;
+        size_t cpuNext = 0;
+        size_t gpuNext = 0;
+    };
+
+    FrameSlot frames[kFrameLatency];
+    std::vector<size_t> openScopes;
+    uint64_t frameIndex;
+    bool inFrame;
+
+    std::vector<std::vector<TraceEvent>> traceFrames; // ring of kTraceFrames resolved frames
+    size_t traceNext;
+    std::vector<ScopeHistory> history;
+    std::unordered_map<std::string, size_t> historyIndex;
+
+    std::chrono::steady_clock::time_point epoch;
+
+    double NowMicroseconds() const;
+    GLuint AcquireQuery(FrameSlot& slot);
+    bool TryResolve(FrameSlot& slot, bool force);
+    void Record(const ScopeRecord& scope, double cpuMs, double gpuMs);
+};
+
+// RAII helper: ProfileScope scope(profiler, "SSAOBlur");
+class ProfileScope {
+public:
+    ProfileScope(Profiler& profiler, const char* name) : profiler(profiler) { profiler.BeginScope(name); }
+    ~ProfileScope() { profiler.EndScope(); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler& profiler;
+};
+
+#endif // PROFILER_H
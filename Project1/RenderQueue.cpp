@@ -0,0 +1,51 @@
+#include "RenderQueue.h"
+#include <algorithm>
+
+uint64_t RenderQueue::MakeKey(unsigned int pass, unsigned int shader, size_t material, float depth, float maxDepth, unsigned int mesh) {
+    // Quantise depth to 24 bits; anything behind maxDepth (or in front of the origin) is clamped.
+    // The top 4 bits are the coarse bucket that sorts above the mesh, the rest sort below it.
+    float normalized = std::min(std::max(depth / maxDepth, 0.0f), 1.0f);
+    uint64_t depthBits = (uint64_t)(normalized * 16777215.0f);
+    uint64_t depthBucket = depthBits >> 20;
+    uint64_t fineDepth = depthBits & 0xFFFFF;
+
+    return ((uint64_t)(pass & 0xF) << 60) |
+        ((uint64_t)(shader & 0xFF) << 52) |
+        ((uint64_t)(material < kMaxMaterial ? material : kMaxMaterial) << 36) |
+        (depthBucket << 32) |
+        ((uint64_t)(mesh & 0xFFF) << 20) |
+        fineDepth;
+}
+
+// LSD radix sort, one byte per pass. All eight histograms are built in a single sweep, and
+// passes whose byte is the same for every item (the pass/shader bytes, usually) are skipped.
+void RenderQueue::Sort() {
+    if (items.size() < 2)
+        return;
+
+    size_t counts[8][256] = {};
+    for (const auto& item : items) {
+        for (int byte = 0; byte < 8; ++byte) {
+            counts[byte][(item.key >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    scratch.resize(items.size());
+    for (int byte = 0; byte < 8; ++byte) {
+        size_t* histogram = counts[byte];
+        if (histogram[(items[0].key >> (byte * 8)) & 0xFF] == items.size())
+            continue;
+
+        size_t offset = 0;
+        for (int digit = 0; digit < 256; ++digit) {
+            size_t count = histogram[digit];
+            histogram[digit] = offset;
+            offset += count;
+        }
+
+        for (const auto& item : items) {
+            scratch[histogram[(item.key >> (byte * 8)) & 0xFF]++] = item;
+        }
+        items.swap(scratch);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One object to draw, ordered by its 64-bit key
+struct DrawItem {
+    uint64_t key;
+    uint32_t object;
+};
+
+// Per-pass list of draw items, radix-sorted by key before submission. Key layout, high to low:
+//   pass (4) | shader (8) | material (16) | depth bucket (4) | mesh (12) | depth (20)
+// so items group by state first and go roughly front to back within a material. Sorting mesh above
+// all but a coarse depth bucket keeps instances of one mesh adjacent, so they merge into one
+// instanced draw per bucket even when other meshes of the material lie between them in depth.
+class RenderQueue {
+public:
+    // Materials above this share the last key value: they still sort by depth, but no longer
+    // group by state among themselves. Submission reads exact ids from the scene.
+    static const size_t kMaxMaterial = 0xFFFF;
+
+    static uint64_t MakeKey(unsigned int pass, unsigned int shader, size_t material, float depth, float maxDepth, unsigned int mesh);
+
+    void Clear() { items.clear(); }
+    void Push(uint64_t key, uint32_t object) { items.push_back({ key, object }); }
+    void Sort();
+
+    const std::vector<DrawItem>& GetItems() const { return items; }
+    bool IsEmpty() const { return items.empty(); }
+
+private:
+    std::vector<DrawItem> items;
+    std::vector<DrawItem> scratch;
+};
+
+#endif // RENDERQUEUE_H
@@ -1,41 +1,100 @@
-#include "renderer.h"
-#include "scene.h"
-#include "mesh.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "Mesh.h"
+#include <algorithm>
 #include <iostream>
-#include <random>
+#include <string>
+
+namespace {
+
+// Pass ids in the high bits of the render queue sort key
+const unsigned int kShadowPassId = 0;
+const unsigned int kGeometryPassId = 1;
+
+// Every cascade gets a layer this size; four 2048 layers cover the view better than one 4096 map
+const int kShadowMapSize = 2048;
+// Blend between logarithmic and uniform cascade splits
+const float kCascadeSplitLambda = 0.75f;
+// How far towards the light casters are gathered in front of a cascade
+const float kShadowCasterDistance = 500.0f;
+// Cached cascades are this fraction larger than their slice so small camera moves keep them valid
+const float kCascadePadding = 0.15f;
+
+// Lighting variant features, one bit per HAS_* define
+const unsigned int kFeaturePointLights = 1 << 0;
+const unsigned int kFeatureSpotLights = 1 << 1;
+const unsigned int kFeatureShadows = 1 << 2;
+const unsigned int kFeatureSSAO = 1 << 3;
+
+} // namespace
 
 Renderer::Renderer(int width, int height)
-    : width(width), height(height), gbuffer(width, height),
+    : width(width), height(height), gbuffer(width, height), ssao(width, height),
     geometryPassShader("geometry_pass.vert", "geometry_pass.frag"),
-    lightingPassShader("lighting_pass.vert", "lighting_pass.frag"),
-    ssaoShader("ssao.vert", "ssao.frag"),
-    ssaoBlurShader("ssao.vert", "ssao_blur.frag"),
-    shadowShader("shadow.vert", "shadow.frag") { // Initialize shadow shader
+    lightingPermutations("lighting_pass.vert", "lighting_pass.frag"),
+    lightingPassShader(nullptr),
+    lightingUniformsStale(false),
+    lightingVariantFeatures(0),
+    shadowShader("shadow.vert", "shadow.frag"), // Initialize shadow shader
+    shadowMaskPermutations("ssao.vert", "shadow_mask.frag"),
+    shadowMaskShader(nullptr),
+    shadowMaskUniformsStale(false),
+    outputFramebuffer(0),
+    shadowMaskIndex(0),
+    shadowHistoryValid(false),
+    lightClusters(width, height),
+    occlusionCuller(width, height),
+    occlusionCulling(true) {
     InitQuad();
-    InitSSAO();
     InitShadowMap();
+    AllocateShadowMaskTargets();
+    InitUniforms();
+    glGenBuffers(1, &instanceVBO);
+    glGenBuffers(1, &indirectBuffer);
 }
 
 Renderer::~Renderer() {
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteBuffers(1, &quadVBO);
-    glDeleteFramebuffers(1, &ssaoFBO);
-    glDeleteFramebuffers(1, &ssaoBlurFBO);
-    glDeleteTextures(1, &ssaoColorBuffer);
-    glDeleteTextures(1, &ssaoColorBufferBlur);
-    glDeleteTextures(1, &noiseTexture);
     glDeleteFramebuffers(1, &depthMapFBO);
     glDeleteTextures(1, &depthMap);
+    glDeleteTextures(1, &staticDepthMap);
+    glDeleteSamplers(1, &shadowDepthSampler);
+    glDeleteSamplers(1, &shadowCompareSampler);
+    DeleteShadowMaskTargets();
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteBuffers(1, &indirectBuffer);
 }
 
-void Renderer::RenderScene(GLuint vao, int vertexCount, Camera& camera, const Scene& scene) {
-    ShadowPass(scene);            // First pass: render depth into shadow map
+void Renderer::RenderScene(GLuint vao, int vertexCount, Camera& camera, Scene& scene) {
+    profiler.BeginFrame();
+    cameraHistory.Advance(camera.GetViewMatrix(), camera.GetProjectionMatrix((float)width / (float)height));
+    lightBuffer.Update(scene);    // Re-upload only the lights that changed
+    SelectLightingVariant();      // Light counts are known now
+    bool hasLocalLights = lightBuffer.GetPointLightCount() + lightBuffer.GetSpotLightCount() > 0;
+    if (shadowSettings.enabled) {
+        ShadowPass(camera, scene); // First pass: render depth into the shadow cascades
+    }
     GeometryPass(vao, vertexCount, camera, scene); // Geometry pass
-    SSAOPass(camera);             // SSAO pass
+    if (ssao.GetSettings().enabled) {
+        SSAOPass();               // SSAO pass
+    }
+    if (shadowSettings.enabled) {
+        SelectShadowMaskVariant(); // Picks up a variant SetShadowSettings requested once it has compiled
+        ShadowMaskPass(scene);    // Filter the soft shadows into screen space
+    }
+    else {
+        shadowHistoryValid = false; // The mask goes stale while it is not rendered
+    }
+    if (hasLocalLights) {
+        LightCullingPass(camera); // Bin lights into view-space clusters
+    }
     LightingPass(camera, scene);  // Lighting pass
+    profiler.EndFrame();
 }
 
 void Renderer::GeometryPass(GLuint vao, int vertexCount, Camera& camera, const Scene& scene) {
+    ProfileScope scope(profiler, "GeometryPass");
     gbuffer.BindForWriting();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -43,113 +102,125 @@ void Renderer::GeometryPass(GLuint vao, int vertexCount, Camera& camera, const S
     glm::mat4 view = camera.GetViewMatrix();
     glm::mat4 projection = camera.GetProjectionMatrix((float)width / (float)height);
 
-    geometryPassShader.setMat4("view", view);
-    geometryPassShader.setMat4("projection", projection);
+    geometryPassShader.set(geometryView, view);
+    geometryPassShader.set(geometryProjection, projection);
 
-    for (const auto& mesh : scene.GetMeshes()) {
-        glm::mat4 model = glm::mat4(1.0f);
-        geometryPassShader.setMat4("model", model);
-        mesh.Draw(geometryPassShader);
+    scene.CullObjects(Frustum(projection * view), visibleObjects);
+    PassView passView = { view, projection, camera.GetFarPlane(), (float)height, lodSettings.pixelError * lodSettings.bias };
+    if (occlusionCulling) {
+        DrawOcclusionCulledObjects(scene, geometryPassShader, passView);
+    }
+    else {
+        DrawVisibleObjects(scene, kGeometryPassId, passView);
     }
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void Renderer::SSAOPass(Camera& camera) {
-    glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-    glClear(GL_COLOR_BUFFER_BIT);
+void Renderer::SSAOPass() {
+    ProfileScope scope(profiler, "SSAOPass");
+    ssao.Render(cameraHistory, gbuffer, quadVAO, profiler);
+}
 
-    ssaoShader.use();
-    for (unsigned int i = 0; i < 64; ++i) {
-        ssaoShader.setVec3("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
+void Renderer::ShadowMaskPass(const Scene& scene) {
+    ProfileScope scope(profiler, "ShadowMaskPass");
+    // Last frame's mask is only usable if it was rendered into these targets with a camera to reproject from
+    bool temporal = shadowSettings.temporal && shadowHistoryValid && cameraHistory.hasPrevious;
+    shadowMaskIndex = 1 - shadowMaskIndex;
+    glBindFramebuffer(GL_FRAMEBUFFER, shadowMaskFBOs[shadowMaskIndex]);
+
+    if (shadowMaskUniformsStale) {
+        InitShadowMaskUniforms();
+        shadowMaskUniformsStale = false;
     }
-    ssaoShader.setMat4("projection", camera.GetProjectionMatrix((float)width / (float)height));
+    shadowMaskShader->use();
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gbuffer.GetPositionTexture());
+    glBindTexture(GL_TEXTURE_2D, gbuffer.GetDepthTexture());
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, gbuffer.GetNormalTexture());
     glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, noiseTexture);
-    glBindVertexArray(quadVAO);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, shadowMaskTextures[1 - shadowMaskIndex]);
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, previousDepthTexture);
+    glActiveTexture(GL_TEXTURE5);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+    glBindSampler(2, shadowDepthSampler);
+    glBindSampler(5, shadowCompareSampler);
+
+    for (int i = 0; i < kShadowCascadeCount; ++i) {
+        shadowMaskShader->set(shadowMaskCascadeMatrices[i], cascadeMatrices[i]);
+        shadowMaskShader->set(shadowMaskCascadeSplits[i], shadowCascades[i].splitFar);
+    }
+    shadowMaskShader->set(shadowMaskLightDirection, scene.GetDirectionalLight().direction);
+    shadowMaskShader->set(shadowMaskInverseView, glm::inverse(cameraHistory.view));
+    shadowMaskShader->set(shadowMaskInverseProjection, glm::inverse(cameraHistory.projection));
+    shadowMaskShader->set(shadowMaskFrameRotation, shadowSettings.temporal ? cameraHistory.GetFrameRotation() : 0.0f);
+    shadowMaskShader->set(shadowMaskTemporal, temporal);
+    shadowMaskShader->set(shadowMaskViewToPreviousClip, cameraHistory.GetViewToPreviousClip());
+    shadowMaskShader->set(shadowMaskPreviousInverseProjection, glm::inverse(cameraHistory.previousProjection));
 
-    glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-    glClear(GL_COLOR_BUFFER_BIT);
-    ssaoBlurShader.use();
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
     glBindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     glBindVertexArray(0);
+    glBindSampler(2, 0);
+    glBindSampler(5, 0);
+
+    // This frame's depth is what next frame reprojects against
+    glCopyImageSubData(gbuffer.GetDepthTexture(), GL_TEXTURE_2D, 0, 0, 0, 0, previousDepthTexture, GL_TEXTURE_2D, 0, 0, 0, 0, width, height, 1);
+    shadowHistoryValid = true;
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void Renderer::LightCullingPass(const Camera& camera) {
+    ProfileScope scope(profiler, "LightCulling");
+    glm::mat4 projection = camera.GetProjectionMatrix((float)width / (float)height);
+    lightClusters.Cull(projection, camera.GetViewMatrix(), camera.GetNearPlane(), camera.GetFarPlane(), lightBuffer);
+}
+
 void Renderer::LightingPass(const Camera& camera, const Scene& scene) {
+    ProfileScope scope(profiler, "LightingPass");
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    lightingPassShader.use();
+    if (lightingUniformsStale) {
+        InitLightingUniforms();
+        lightingUniformsStale = false;
+    }
+    lightingPassShader->use();
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gbuffer.GetPositionTexture());
-    lightingPassShader.setInt("gPosition", 0);
-
+    glBindTexture(GL_TEXTURE_2D, gbuffer.GetDepthTexture());
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, gbuffer.GetNormalTexture());
-    lightingPassShader.setInt("gNormal", 1);
-
     glActiveTexture(GL_TEXTURE2);
     glBindTexture(GL_TEXTURE_2D, gbuffer.GetAlbedoTexture());
-    lightingPassShader.setInt("gAlbedoSpec", 2);
-
     glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
-    lightingPassShader.setInt("ssao", 3);
-
+    glBindTexture(GL_TEXTURE_2D, ssao.GetOcclusionTexture());
     glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
-    lightingPassShader.setInt("shadowMap", 4);
-
-    lightingPassShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
+    glBindTexture(GL_TEXTURE_2D, shadowMaskTextures[shadowMaskIndex]);
 
     // Set directional light uniforms
     const auto& directionalLight = scene.GetDirectionalLight();
-    lightingPassShader.setVec3("dirLight.direction", directionalLight.direction);
-    lightingPassShader.setVec3("dirLight.ambient", directionalLight.ambient);
-    lightingPassShader.setVec3("dirLight.diffuse", directionalLight.diffuse);
-    lightingPassShader.setVec3("dirLight.specular", directionalLight.specular);
-
-    // Set point lights uniforms
-    const auto& pointLights = scene.GetPointLights();
-    lightingPassShader.setInt("numPointLights", pointLights.size());
-    for (unsigned int i = 0; i < pointLights.size(); i++) {
-        lightingPassShader.setVec3("pointLights[" + std::to_string(i) + "].position", pointLights[i].position);
-        lightingPassShader.setVec3("pointLights[" + std::to_string(i) + "].ambient", pointLights[i].ambient);
-        lightingPassShader.setVec3("pointLights[" + std::to_string(i) + "].diffuse", pointLights[i].diffuse);
-        lightingPassShader.setVec3("pointLights[" + std::to_string(i) + "].specular", pointLights[i].specular);
-        lightingPassShader.setFloat("pointLights[" + std::to_string(i) + "].constant", pointLights[i].constant);
-        lightingPassShader.setFloat("pointLights[" + std::to_string(i) + "].linear", pointLights[i].linear);
-        lightingPassShader.setFloat("pointLights[" + std::to_string(i) + "].quadratic", pointLights[i].quadratic);
-    }
-
-    // Set spot lights uniforms
-    const auto& spotLights = scene.GetSpotLights();
-    lightingPassShader.setInt("numSpotLights", spotLights.size());
-    for (unsigned int i = 0; i < spotLights.size(); i++) {
-        lightingPassShader.setVec3("spotLights[" + std::to_string(i) + "].position", spotLights[i].position);
-        lightingPassShader.setVec3("spotLights[" + std::to_string(i) + "].direction", spotLights[i].direction);
-        lightingPassShader.setVec3("spotLights[" + std::to_string(i) + "].ambient", spotLights[i].ambient);
-        lightingPassShader.setVec3("spotLights[" + std::to_string(i) + "].diffuse", spotLights[i].diffuse);
-        lightingPassShader.setVec3("spotLights[" + std::to_string(i) + "].specular", spotLights[i].specular);
-        lightingPassShader.setFloat("spotLights[" + std::to_string(i) + "].constant", spotLights[i].constant);
-        lightingPassShader.setFloat("spotLights[" + std::to_string(i) + "].linear", spotLights[i].linear);
-        lightingPassShader.setFloat("spotLights[" + std::to_string(i) + "].quadratic", spotLights[i].quadratic);
-        lightingPassShader.setFloat("spotLights[" + std::to_string(i) + "].cutOff", spotLights[i].cutOff);
-        lightingPassShader.setFloat("spotLights[" + std::to_string(i) + "].outerCutOff", spotLights[i].outerCutOff);
-    }
+    lightingPassShader->set(dirLightDirection, directionalLight.direction);
+    lightingPassShader->set(dirLightAmbient, directionalLight.ambient);
+    lightingPassShader->set(dirLightDiffuse, directionalLight.diffuse);
+    lightingPassShader->set(dirLightSpecular, directionalLight.specular);
+
+    // Point and spot lights live in shader storage buffers kept up to date by lightBuffer,
+    // and each fragment walks only the light list of its cluster
+    lightBuffer.Bind();
+    lightClusters.Bind();
+    // World position is rebuilt from the G-buffer depth
+    glm::mat4 projection = camera.GetProjectionMatrix((float)width / (float)height);
+    lightingPassShader->set(lightingInverseProjection, glm::inverse(projection));
+    lightingPassShader->set(lightingInverseView, glm::inverse(camera.GetViewMatrix()));
+    lightingPassShader->set(clusterTileSize, lightClusters.GetTileSize());
+    lightingPassShader->set(clusterSliceScale, lightClusters.GetSliceScale());
+    lightingPassShader->set(clusterSliceBias, lightClusters.GetSliceBias());
 
     // Set the camera position uniform
-    lightingPassShader.setVec3("viewPos", camera.GetPosition());
+    lightingPassShader->set(lightingViewPos, camera.GetPosition());
 
     // Render a quad for the lighting pass
     glBindVertexArray(quadVAO);
@@ -158,32 +229,275 @@ void Renderer::LightingPass(const Camera& camera, const Scene& scene) {
 }
 
 
-void Renderer::ShadowPass(const Scene& scene) {
-    glViewport(0, 0, 4096, 4096); // Set viewport to shadow map size
+void Renderer::ShadowPass(const Camera& camera, const Scene& scene) {
+    ProfileScope scope(profiler, "ShadowPass");
+    glViewport(0, 0, kShadowMapSize, kShadowMapSize);
     glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glClear(GL_DEPTH_BUFFER_BIT);
 
     shadowShader.use();
 
-    glm::mat4 lightProjection, lightView;
-    float near_plane = 1.0f, far_plane = 50.0f; // Adjust far_plane based on scene size
-    lightProjection = glm::ortho(-20.0f, 20.0f, -20.0f, 20.0f, near_plane, far_plane);
-    glm::vec3 lightPos = scene.GetDirectionalLight().position; // Make sure light position is correctly set
-    lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
-    lightSpaceMatrix = lightProjection * lightView;
-
-    shadowShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-
-    for (const auto& mesh : scene.GetMeshes()) {
-        glm::mat4 model = glm::mat4(1.0f);
-        shadowShader.setMat4("model", model);
-        mesh.Draw(shadowShader);
+    // Cascades cover consecutive slices of the camera frustum, each fitted to its own slice.
+    // A slice only forces its cascade to move once it leaves the padded placement cached below.
+    glm::mat4 cameraProjection = camera.GetProjectionMatrix((float)width / (float)height);
+    glm::mat4 inverseCameraViewProjection = glm::inverse(cameraProjection * camera.GetViewMatrix());
+    glm::mat4 lightView = ShadowLightView(scene.GetDirectionalLight().direction);
+    float splits[kShadowCascadeCount];
+    ComputeCascadeSplits(camera.GetNearPlane(), camera.GetFarPlane(), kCascadeSplitLambda, splits, kShadowCascadeCount);
+    FitShadowCascades(inverseCameraViewProjection, camera.GetNearPlane(), camera.GetFarPlane(), splits, lightView,
+        kShadowMapSize, shadowCascades, kShadowCascadeCount);
+
+    // Casters in front of a cached near plane (moved or added since) are clamped onto it
+    // rather than clipped, which keeps their shadow
+    glEnable(GL_DEPTH_CLAMP);
+    const auto& objects = scene.GetObjects();
+    for (int i = 0; i < kShadowCascadeCount; ++i) {
+        ShadowCache& cache = shadowCaches[i];
+        bool staticDirty = false;
+        if (!cache.valid || cache.lightRevision != scene.GetDirectionalLightRevision() || !cache.cascade.Contains(shadowCascades[i])) {
+            cache.valid = true;
+            cache.cascade = shadowCascades[i].Padded(kCascadePadding, kShadowMapSize);
+            cache.lightRevision = scene.GetDirectionalLightRevision();
+            staticDirty = true;
+        }
+
+        // Casters between the light and the slice still shadow it, so cull with the near plane pulled back
+        const ShadowCascade& cascade = cache.cascade;
+        float cullNear = cascade.GetNearDistance() - kShadowCasterDistance;
+        scene.CullObjects(Frustum(cascade.GetProjection(cullNear) * lightView), shadowCasters);
+        if (!staticDirty && scene.GetRevision() != cache.sceneRevision) {
+            staticDirty = StaticCastersChanged(scene, cache);
+        }
+
+        if (staticDirty) {
+            // Tighten the near plane to the nearest caster for depth precision
+            cache.nearDistance = cascade.GetNearDistance();
+            for (size_t index : shadowCasters) {
+                cache.nearDistance = std::min(cache.nearDistance, -objects[index].worldBounds.Transformed(lightView).max.z);
+            }
+            cache.nearDistance = std::max(cache.nearDistance, cullNear);
+            cascadeMatrices[i] = cascade.GetProjection(cache.nearDistance) * lightView;
+        }
+
+        glm::mat4 lightProjection = cascade.GetProjection(cache.nearDistance);
+        PassView passView = { lightView, lightProjection, cascade.GetFarDistance() - cache.nearDistance, (float)kShadowMapSize,
+            lodSettings.shadowPixelError * lodSettings.bias };
+        shadowShader.set(shadowLightSpaceMatrix, cascadeMatrices[i]);
+
+        if (staticDirty) {
+            visibleObjects.clear();
+            for (size_t index : shadowCasters) {
+                if (!objects[index].dynamic)
+                    visibleObjects.push_back(index);
+            }
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticDepthMap, 0, i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            DrawVisibleObjects(scene, kShadowPassId, passView);
+            cache.casters = visibleObjects;
+            cache.sceneRevision = scene.GetRevision();
+        }
+
+        visibleObjects.clear();
+        for (size_t index : shadowCasters) {
+            if (objects[index].dynamic)
+                visibleObjects.push_back(index);
+        }
+
+        // With nothing dynamic now or last frame, the layer from the last refresh is still right
+        bool hasDynamicCasters = !visibleObjects.empty();
+        if (staticDirty || hasDynamicCasters || cache.hasDynamicCasters) {
+            glCopyImageSubData(staticDepthMap, GL_TEXTURE_2D_ARRAY, 0, 0, 0, i,
+                depthMap, GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, kShadowMapSize, kShadowMapSize, 1);
+            if (hasDynamicCasters) {
+                glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0, i);
+                DrawVisibleObjects(scene, kShadowPassId, passView);
+            }
+        }
+        cache.hasDynamicCasters = hasDynamicCasters;
     }
+    glDisable(GL_DEPTH_CLAMP);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glViewport(0, 0, width, height); // Reset viewport
 }
 
+bool Renderer::StaticCastersChanged(const Scene& scene, const ShadowCache& cache) const {
+    // Catches casters that moved out of the cascade or turned dynamic...
+    const auto& objects = scene.GetObjects();
+    for (size_t index : cache.casters) {
+        if (objects[index].revision > cache.sceneRevision)
+            return true;
+    }
+    // ...and static casters that were added, moved in or changed inside it
+    for (size_t index : shadowCasters) {
+        if (!objects[index].dynamic && objects[index].revision > cache.sceneRevision)
+            return true;
+    }
+    return false;
+}
+
+// Picks the coarsest LOD whose error, projected at the object's nearest depth, stays under the
+// pass's pixel threshold
+unsigned int Renderer::SelectLod(const Mesh& mesh, const Scene::SceneObject& object, const PassView& passView, float depth) const {
+    if (mesh.GetLods().size() < 2 || passView.pixelError <= 0.0f)
+        return 0;
+
+    // projection[1][1] is cot(fov/2) for perspective and 2/height for orthographic projections
+    float pixelsPerUnit = passView.projection[1][1] * passView.viewportHeight * 0.5f;
+    bool perspective = passView.projection[3][3] == 0.0f;
+    float scale = MaxAxisScale(object.transform);
+    if (perspective) {
+        float nearest = depth - mesh.GetBoundingSphere().radius * scale;
+        if (nearest <= 0.0f)
+            return 0; // Camera inside or right up against the object
+        pixelsPerUnit /= nearest;
+    }
+
+    return mesh.SelectLod(passView.pixelError / (pixelsPerUnit * scale));
+}
+
+// Queues the visible objects with a sort key (pass, shader, material, front-to-back depth),
+// radix-sorts them, then streams their transforms and one indirect command per run of the same
+// mesh and LOD to the GPU. Each material is bound once and drawn with a single multi-draw.
+void Renderer::DrawVisibleObjects(const Scene& scene, unsigned int pass, const PassView& passView) {
+    if (visibleObjects.empty())
+        return;
+
+    BuildDrawCommands(scene, pass, passView);
+
+    // Orphan the previous contents so the driver does not stall on draws still reading them
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instanceData.size() * sizeof(InstanceData), instanceData.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, drawCommands.size() * sizeof(DrawElementsIndirectCommand), drawCommands.data(), GL_STREAM_DRAW);
+
+    SubmitDrawCommands(scene, instanceVBO, 0, pass != kShadowPassId); // Depth-only shadows sample nothing
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void Renderer::DrawOcclusionCulledObjects(const Scene& scene, Shader& shader, const PassView& passView) {
+    if (visibleObjects.empty())
+        return;
+
+    BuildDrawCommands(scene, kGeometryPassId, passView);
+
+    const auto& objects = scene.GetObjects();
+    const auto& items = renderQueue.GetItems();
+    cullInstances.resize(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        const AABB& bounds = objects[items[i].object].worldBounds;
+        cullInstances[i].boundsMin = glm::vec4(bounds.min, 0.0f);
+        cullInstances[i].boundsMax = glm::vec4(bounds.max, 0.0f);
+        cullInstances[i].command = glm::uvec4(instanceCommands[i], 0, 0, 0);
+    }
+    occlusionCuller.Upload(instanceData, cullInstances, drawCommands);
+
+    // Phase 1: whatever the previous frame's depth does not hide
+    occlusionCuller.CullFirstPhase();
+    shader.use();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, occlusionCuller.GetCommandBuffer());
+    SubmitDrawCommands(scene, occlusionCuller.GetInstanceBuffer(), 0, true);
+
+    // Phase 2: the rejected instances against this frame's depth so far. The pyramid built here
+    // is also next frame's phase 1 occluder; it lacks phase 2's draws, which only makes it conservative.
+    occlusionCuller.BuildPyramid(gbuffer.GetDepthTexture(), passView.projection * passView.view);
+    occlusionCuller.CullSecondPhase();
+    shader.use();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, occlusionCuller.GetCommandBuffer());
+    SubmitDrawCommands(scene, occlusionCuller.GetInstanceBuffer(), drawCommands.size(), true);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void Renderer::BuildDrawCommands(const Scene& scene, unsigned int pass, const PassView& passView) {
+    const auto& meshes = scene.GetMeshes();
+    const auto& objects = scene.GetObjects();
+
+    renderQueue.Clear();
+    objectLods.resize(objects.size());
+    for (size_t index : visibleObjects) {
+        const auto& object = objects[index];
+        float depth = -(passView.view * glm::vec4(object.worldBounds.GetCenter(), 1.0f)).z;
+        objectLods[index] = (unsigned char)SelectLod(meshes[object.mesh], object, passView, depth);
+        // The vertex format picks the arena VAO, so it sorts above material like a shader change would
+        unsigned int vertexFormat = (unsigned int)meshes[object.mesh].GetVertexFormat();
+        uint64_t key = RenderQueue::MakeKey(pass, vertexFormat, scene.GetMeshMaterial(object.mesh), depth, passView.maxDepth, (unsigned int)object.mesh);
+        renderQueue.Push(key, (uint32_t)index);
+    }
+    renderQueue.Sort();
+
+    const auto& items = renderQueue.GetItems();
+    instanceData.resize(items.size());
+    instanceCommands.resize(items.size());
+    drawCommands.clear();
+    drawCommandMaterials.clear();
+    drawCommandMeshes.clear();
+    materialMeshes.resize(meshes.size());
+    size_t previousMesh = meshes.size();
+    unsigned int previousLod = 0;
+    for (size_t i = 0; i < items.size(); ++i) {
+        const auto& object = objects[items[i].object];
+        const Mesh& mesh = meshes[object.mesh];
+        instanceData[i].model = object.transform;
+        instanceData[i].positionOffset = glm::vec4(mesh.GetPositionOffset(), 0.0f);
+        instanceData[i].positionScale = glm::vec4(mesh.GetPositionScale(), 0.0f);
+
+        // Adjacent items of the same mesh and LOD collapse into one instanced command
+        unsigned int lod = objectLods[items[i].object];
+        if (object.mesh == previousMesh && lod == previousLod) {
+            drawCommands.back().instanceCount++;
+            instanceCommands[i] = (GLuint)drawCommands.size() - 1;
+            continue;
+        }
+        previousMesh = object.mesh;
+        previousLod = lod;
+
+        // baseInstance picks this command's first matrix out of the instance buffer
+        // The key keeps only the low bits of the material, so take the id from the scene
+        size_t material = scene.GetMeshMaterial(object.mesh);
+        const GeometryAllocation& allocation = mesh.GetAllocation();
+        const MeshLod& range = mesh.GetLods()[lod];
+        instanceCommands[i] = (GLuint)drawCommands.size();
+        drawCommands.push_back({ range.indexCount, 1, allocation.firstIndex + range.firstIndex, allocation.baseVertex, (GLuint)i });
+        drawCommandMaterials.push_back(material);
+        drawCommandMeshes.push_back(object.mesh);
+        materialMeshes[material] = object.mesh;
+    }
+}
+
+void Renderer::SubmitDrawCommands(const Scene& scene, GLuint instanceBuffer, size_t commandOffset, bool bindTextures) {
+    const auto& meshes = scene.GetMeshes();
+
+    // Runs share a vertex format, and a material when textures are bound; the arena VAO only
+    // changes between formats
+    VertexFormat boundFormat = VertexFormat::Full;
+    bool arenaBound = false;
+    size_t runStart = 0;
+    while (runStart < drawCommands.size()) {
+        size_t material = drawCommandMaterials[runStart];
+        VertexFormat format = meshes[drawCommandMeshes[runStart]].GetVertexFormat();
+        size_t runEnd = runStart + 1;
+        while (runEnd < drawCommands.size() && (!bindTextures || drawCommandMaterials[runEnd] == material) &&
+            meshes[drawCommandMeshes[runEnd]].GetVertexFormat() == format) {
+            ++runEnd;
+        }
+
+        if (!arenaBound || format != boundFormat) {
+            GeometryArena::Get(format).Bind(instanceBuffer);
+            boundFormat = format;
+            arenaBound = true;
+        }
+
+        // Textures change only at material boundaries
+        if (bindTextures) {
+            meshes[materialMeshes[material]].BindTextures();
+        }
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)((commandOffset + runStart) * sizeof(DrawElementsIndirectCommand)),
+            (GLsizei)(runEnd - runStart), 0);
+        runStart = runEnd;
+    }
+
+    glBindVertexArray(0);
+}
 
 void Renderer::InitQuad() {
     float quadVertices[] = {
@@ -206,90 +520,106 @@ void Renderer::InitQuad() {
     glBindVertexArray(0);
 }
 
-void Renderer::InitSSAO() {
-    // SSAO framebuffer
-    glGenFramebuffers(1, &ssaoFBO);
-    glGenFramebuffers(1, &ssaoBlurFBO);
-
-    // SSAO color buffer
-    glGenTextures(1, &ssaoColorBuffer);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RED, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBuffer, 0);
-
-    // SSAO blur color buffer
-    glGenTextures(1, &ssaoColorBufferBlur);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RED, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBufferBlur, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+void Renderer::InitUniforms() {
+    geometryView = geometryPassShader.getUniform<glm::mat4>("view");
+    geometryProjection = geometryPassShader.getUniform<glm::mat4>("projection");
+    // Every mesh binds its textures to the same two units, so draws never touch the samplers
+    geometryPassShader.use();
+    geometryPassShader.setInt("texture_diffuse", Mesh::kDiffuseTextureUnit);
+    geometryPassShader.setInt("texture_specular", Mesh::kSpecularTextureUnit);
+    glUseProgram(0);
 
-    // Generate sample kernel
-    std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0);
-    std::default_random_engine generator;
-    for (unsigned int i = 0; i < 64; ++i) {
-        glm::vec3 sample(
-            randomFloats(generator) * 2.0 - 1.0,
-            randomFloats(generator) * 2.0 - 1.0,
-            randomFloats(generator)
-        );
-        sample = glm::normalize(sample);
-        sample *= randomFloats(generator);
-        float scale = float(i) / 64.0;
-
-        // Scale samples s.t. they are more aligned to the origin
-        scale = 0.1f + scale * scale * (1.0f - 0.1f);
-        sample *= scale;
-        ssaoKernel.push_back(sample);
-    }
+    shadowLightSpaceMatrix = shadowShader.getUniform<glm::mat4>("lightSpaceMatrix");
 
-    // Generate noise texture
-    std::vector<glm::vec3> ssaoNoise;
-    for (unsigned int i = 0; i < 16; i++) {
-        glm::vec3 noise(
-            randomFloats(generator) * 2.0 - 1.0,
-            randomFloats(generator) * 2.0 - 1.0,
-            0.0f
-        );
-        ssaoNoise.push_back(noise);
-    }
+    // The lighting variant depends on the scene's lights, so RenderScene picks it on the first frame
+    SelectShadowMaskVariant();
+}
+
+void Renderer::InitLightingUniforms() {
+    dirLightDirection = lightingPassShader->getUniform<glm::vec3>("dirLight.direction");
+    dirLightAmbient = lightingPassShader->getUniform<glm::vec3>("dirLight.ambient");
+    dirLightDiffuse = lightingPassShader->getUniform<glm::vec3>("dirLight.diffuse");
+    dirLightSpecular = lightingPassShader->getUniform<glm::vec3>("dirLight.specular");
+    lightingInverseView = lightingPassShader->getUniform<glm::mat4>("inverseView");
+    lightingInverseProjection = lightingPassShader->getUniform<glm::mat4>("inverseProjection");
+    clusterTileSize = lightingPassShader->getUniform<glm::vec2>("clusterTileSize");
+    clusterSliceScale = lightingPassShader->getUniform<float>("clusterSliceScale");
+    clusterSliceBias = lightingPassShader->getUniform<float>("clusterSliceBias");
+    lightingViewPos = lightingPassShader->getUniform<glm::vec3>("viewPos");
+
+    // Sampler units never change, so assign them once instead of every frame
+    lightingPassShader->use();
+    lightingPassShader->setInt("gDepth", 0);
+    lightingPassShader->setInt("gNormal", 1);
+    lightingPassShader->setInt("gAlbedoSpec", 2);
+    lightingPassShader->setInt("ssao", 3);
+    lightingPassShader->setInt("shadowMask", 4);
+    glUseProgram(0);
+}
 
-    glGenTextures(1, &noiseTexture);
-    glBindTexture(GL_TEXTURE_2D, noiseTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, 4, 4, 0, GL_RGB, GL_FLOAT, &ssaoNoise[0]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+void Renderer::InitShadowMaskUniforms() {
+    for (int i = 0; i < kShadowCascadeCount; ++i) {
+        shadowMaskCascadeMatrices[i] = shadowMaskShader->getUniform<glm::mat4>("cascadeMatrices[" + std::to_string(i) + "]");
+        shadowMaskCascadeSplits[i] = shadowMaskShader->getUniform<float>("cascadeSplits[" + std::to_string(i) + "]");
+    }
+    shadowMaskLightDirection = shadowMaskShader->getUniform<glm::vec3>("lightDirection");
+    shadowMaskInverseView = shadowMaskShader->getUniform<glm::mat4>("inverseView");
+    shadowMaskInverseProjection = shadowMaskShader->getUniform<glm::mat4>("inverseProjection");
+    shadowMaskFrameRotation = shadowMaskShader->getUniform<float>("frameRotation");
+    shadowMaskTemporal = shadowMaskShader->getUniform<bool>("temporal");
+    shadowMaskViewToPreviousClip = shadowMaskShader->getUniform<glm::mat4>("viewToPreviousClip");
+    shadowMaskPreviousInverseProjection = shadowMaskShader->getUniform<glm::mat4>("previousInverseProjection");
+
+    shadowMaskShader->use();
+    shadowMaskShader->setInt("gDepth", 0);
+    shadowMaskShader->setInt("gNormal", 1);
+    shadowMaskShader->setInt("shadowMap", 2);
+    shadowMaskShader->setInt("history", 3);
+    shadowMaskShader->setInt("previousDepth", 4);
+    shadowMaskShader->setInt("shadowMapCompare", 5);
+    glUseProgram(0);
 }
 
 void Renderer::InitShadowMap() {
     glGenFramebuffers(1, &depthMapFBO);
 
-    glGenTextures(1, &depthMap);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, 4096, 4096, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Ensure smooth sampling
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    // depthMap is what the shadow mask samples; staticDepthMap holds the cached static casters
+    // that ShadowPass copies into it
+    GLuint* maps[2] = { &depthMap, &staticDepthMap };
+    for (GLuint* map : maps) {
+        glGenTextures(1, map);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, *map);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, kShadowMapSize, kShadowMapSize, kShadowCascadeCount, 0,
+            GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Ensure smooth sampling
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        float borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
+        glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+    }
+
+    // The shadow mask reads depthMap both ways: raw depth for the blocker search and hard shadows,
+    // hardware comparison (bilinear-filtered results) for PCF, gather and the PCSS filter
     float borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+    glGenSamplers(1, &shadowDepthSampler);
+    glSamplerParameteri(shadowDepthSampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glSamplerParameteri(shadowDepthSampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glGenSamplers(1, &shadowCompareSampler);
+    glSamplerParameteri(shadowCompareSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(shadowCompareSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(shadowCompareSampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glSamplerParameteri(shadowCompareSampler, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    GLuint samplers[2] = { shadowDepthSampler, shadowCompareSampler };
+    for (GLuint sampler : samplers) {
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        glSamplerParameterfv(sampler, GL_TEXTURE_BORDER_COLOR, borderColor);
+    }
 
+    // ShadowPass attaches each layer in turn; layer 0 stands in for the completeness check
     glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0, 0);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
 
@@ -302,16 +632,103 @@ void Renderer::InitShadowMap() {
 
 
 
+void Renderer::AllocateShadowMaskTargets() {
+    GLuint* targets[3] = { &shadowMaskTextures[0], &shadowMaskTextures[1], &previousDepthTexture };
+    for (GLuint* target : targets) {
+        glGenTextures(1, target);
+        glBindTexture(GL_TEXTURE_2D, *target);
+        if (target == &previousDepthTexture) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        }
+        else {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, width, height, 0, GL_RG, GL_FLOAT, NULL);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(2, shadowMaskFBOs);
+    for (int i = 0; i < 2; ++i) {
+        glBindFramebuffer(GL_FRAMEBUFFER, shadowMaskFBOs[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, shadowMaskTextures[i], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Shadow mask framebuffer not complete!" << std::endl;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    shadowHistoryValid = false;
+}
+
+void Renderer::DeleteShadowMaskTargets() {
+    glDeleteFramebuffers(2, shadowMaskFBOs);
+    glDeleteTextures(2, shadowMaskTextures);
+    glDeleteTextures(1, &previousDepthTexture);
+}
+
+void Renderer::SetShadowSettings(const ShadowSettings& settings) {
+    shadowSettings = settings;
+    shadowSettings.sampleCount = std::min(std::max(1, shadowSettings.sampleCount), 16);
+    // The filter and sample count are compiled in
+    SelectShadowMaskVariant();
+}
+
+void Renderer::SelectLightingVariant() {
+    unsigned int features = 0;
+    features |= lightBuffer.GetPointLightCount() > 0 ? kFeaturePointLights : 0;
+    features |= lightBuffer.GetSpotLightCount() > 0 ? kFeatureSpotLights : 0;
+    features |= shadowSettings.enabled ? kFeatureShadows : 0;
+    features |= ssao.GetSettings().enabled ? kFeatureSSAO : 0;
+
+    ShaderDefines defines;
+    defines.Set("HAS_POINT_LIGHTS", (features & kFeaturePointLights) != 0)
+        .Set("HAS_SPOT_LIGHTS", (features & kFeatureSpotLights) != 0)
+        .Set("HAS_SHADOWS", (features & kFeatureShadows) != 0)
+        .Set("HAS_SSAO", (features & kFeatureSSAO) != 0)
+        .Set("CLUSTER_GRID_X", (int)LightClusters::kGridX)
+        .Set("CLUSTER_GRID_Y", (int)LightClusters::kGridY)
+        .Set("CLUSTER_GRID_Z", (int)LightClusters::kGridZ);
+    Shader& variant = lightingPermutations.Get(defines);
+    // While the new variant compiles, keep the previous one if it only lacks features: it then
+    // reads nothing RenderScene stopped updating, and just leaves the new lights or effects out
+    // for a few frames. A variant with a feature that is now off must go at once, even if that waits.
+    bool previousIsSubset = (lightingVariantFeatures & ~features) == 0;
+    if (lightingPassShader && previousIsSubset && !variant.isReady())
+        return;
+    if (&variant != lightingPassShader) {
+        lightingPassShader = &variant;
+        lightingVariantFeatures = features;
+        lightingUniformsStale = true;
+    }
+}
+
+void Renderer::SelectShadowMaskVariant() {
+    ShaderDefines defines;
+    defines.Set("SHADOW_FILTER", (int)shadowSettings.filter)
+        .Set("SHADOW_SAMPLES", shadowSettings.sampleCount)
+        .Set("CASCADE_COUNT", kShadowCascadeCount);
+    Shader& variant = shadowMaskPermutations.Get(defines);
+    if (shadowMaskShader && !variant.isReady())
+        return; // Called every frame while shadows are on, so the switch happens once it is built
+    if (&variant != shadowMaskShader) {
+        shadowMaskShader = &variant;
+        shadowMaskUniformsStale = true;
+    }
+}
+
 void Renderer::Resize(int newWidth, int newHeight) {
     width = newWidth;
     height = newHeight;
     gbuffer.Resize(newWidth, newHeight);
+    lightClusters.Resize(newWidth, newHeight);
+    occlusionCuller.Resize(newWidth, newHeight);
 
-    // Resize SSAO framebuffer textures
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, newWidth, newHeight, 0, GL_RED, GL_FLOAT, nullptr);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, newWidth, newHeight, 0, GL_RED, GL_FLOAT, nullptr);
+    ssao.Resize(newWidth, newHeight);
+    DeleteShadowMaskTargets();
+    AllocateShadowMaskTargets();
+    cameraHistory.Reset(); // Last frame's projection no longer matches the targets
 
     // Recalculate projection matrices etc as needed
 }
\ No newline at end of file
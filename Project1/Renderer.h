@@ -3,47 +3,193 @@
 
 #include <vector>
 #include <glm/glm.hpp>
-#include "gbuffer.h"
-#include "shader.h"
-#include "camera.h"
-#include "scene.h"
+#include "GBuffer.h"
+#include "Shader.h"
+#include "ShaderPermutations.h"
+#include "Camera.h"
+#include "Scene.h"
+#include "Profiler.h"
+#include "LightBuffer.h"
+#include "LightClusters.h"
+#include "OcclusionCuller.h"
+#include "ShadowCascades.h"
+#include "SSAO.h"
+#include "GeometryArena.h"
+#include "RenderQueue.h"
+
+// How eagerly objects switch to simplified LODs. A LOD is used once its simplification error,
+// projected to the screen (or shadow map), stays below the pixel threshold times bias.
+struct LodSettings {
+    float bias = 1.0f;             // > 1 switches to coarser LODs sooner, 0 always draws LOD 0
+    float pixelError = 1.0f;       // Camera views, in pixels
+    float shadowPixelError = 2.0f; // Shadow views, in shadow map texels
+};
+
+// How the shadow mask filters the cascades, cheapest first. The tier is compiled into shadow_mask.frag.
+enum class ShadowFilter {
+    Hard,   // One depth comparison
+    PCF,    // Four hardware-filtered comparison taps (3x3 tent)
+    Gather, // Four textureGather comparisons (4x4 box)
+    PCSS    // Blocker search and variable penumbra, sampleCount taps each
+};
+
+// Soft shadows are filtered into a screen-space mask before lighting. With temporal accumulation the
+// Poisson taps rotate every frame and the mask converges over several frames from far fewer taps.
+struct ShadowSettings {
+    bool enabled = true; // Off skips the shadow passes and the lighting pass's shadow lookup
+    ShadowFilter filter = ShadowFilter::PCSS;
+    bool temporal = true;
+    int sampleCount = 4; // PCSS blocker search and filter taps per pixel per frame, at most 16
+};
 
 class Renderer {
 public:
+    // Compiled into shadow_mask.frag as CASCADE_COUNT
+    static const int kShadowCascadeCount = 4;
+
     Renderer(int width, int height);
     ~Renderer();
 
-    void RenderScene(GLuint vao, int vertexCount, Camera& camera, const Scene& scene);
+    void RenderScene(GLuint vao, int vertexCount, Camera& camera, Scene& scene);
     void Resize(int newWidth, int newHeight); // Add this method
 
+    Profiler& GetProfiler() { return profiler; }
+
+    void SetLodSettings(const LodSettings& settings) { lodSettings = settings; }
+    const LodSettings& GetLodSettings() const { return lodSettings; }
+
+    void SetSSAOSettings(const SSAOSettings& settings) { ssao.SetSettings(settings); }
+    const SSAOSettings& GetSSAOSettings() const { return ssao.GetSettings(); }
+
+    void SetShadowSettings(const ShadowSettings& settings);
+    const ShadowSettings& GetShadowSettings() const { return shadowSettings; }
+
+    // GPU Hi-Z occlusion culling of the geometry pass; off draws every frustum-visible object
+    void SetOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
+    bool IsOcclusionCullingEnabled() const { return occlusionCulling; }
+
+    // Framebuffer the lighting pass resolves into; 0 (the window) unless rendering offscreen
+    void SetOutputFramebuffer(GLuint fbo) { outputFramebuffer = fbo; }
+
 private:
     int width;
     int height;
     GBuffer gbuffer;
+    SSAO ssao;
     Shader geometryPassShader;
-    Shader lightingPassShader;
-    Shader ssaoShader;
-    Shader ssaoBlurShader;
+    ShaderPermutations lightingPermutations;
+    Shader* lightingPassShader; // Variant for the current lights and settings, see SelectLightingVariant
+    bool lightingUniformsStale; // Handles still belong to the previous variant
+    unsigned int lightingVariantFeatures; // kFeature* bits lightingPassShader was built with
     Shader shadowShader; // Add a shader variable for shadow mapping
+    ShaderPermutations shadowMaskPermutations;
+    Shader* shadowMaskShader;   // Variant for the current ShadowSettings
+    bool shadowMaskUniformsStale;
     GLuint quadVAO;
     GLuint quadVBO;
-    GLuint ssaoFBO;
-    GLuint ssaoBlurFBO;
-    GLuint ssaoColorBuffer;
-    GLuint ssaoColorBufferBlur;
-    GLuint noiseTexture;
     GLuint depthMapFBO;
-    GLuint depthMap;
-    std::vector<glm::vec3> ssaoKernel;
-    glm::mat4 lightSpaceMatrix;
+    GLuint depthMap; // Depth texture array, one layer per cascade
+    GLuint outputFramebuffer;
+    GLuint staticDepthMap; // Same layout as depthMap, static casters only
+    GLuint shadowDepthSampler;   // Reads depthMap as raw depth
+    GLuint shadowCompareSampler; // Reads depthMap through hardware depth comparison
+    ShadowCascade shadowCascades[kShadowCascadeCount]; // This frame's tight fit; its splits drive cascade selection
+    glm::mat4 cascadeMatrices[kShadowCascadeCount];    // Light view-projection each layer was rendered with
+
+    // A cascade's static layer is kept until the light, the cascade placement or one of its static
+    // casters changes. Dynamic casters are drawn over a copy of it whenever there are any.
+    struct ShadowCache {
+        bool valid = false;
+        ShadowCascade cascade;           // Padded placement the layers were rendered with
+        float nearDistance = 0.0f;
+        uint64_t lightRevision = 0;
+        uint64_t sceneRevision = 0;      // Scene revision the static layer was rendered at
+        std::vector<size_t> casters;     // Static casters in the static layer
+        bool hasDynamicCasters = false;  // depthMap's layer holds dynamic casters over the static copy
+    };
+    ShadowCache shadowCaches[kShadowCascadeCount];
+    ShadowSettings shadowSettings;
+    CameraHistory cameraHistory;
+    GLuint shadowMaskFBOs[2];
+    GLuint shadowMaskTextures[2]; // RG16F shadow and frames accumulated; written alternately, the other is the history
+    GLuint previousDepthTexture;  // The G-buffer depth as of the last frame
+    int shadowMaskIndex;          // Which of shadowMaskTextures this frame writes
+    bool shadowHistoryValid;      // False until a frame has been rendered into freshly allocated targets
+    std::vector<size_t> shadowCasters; // Every caster touching the cascade being drawn
+    Profiler profiler;
+    LightBuffer lightBuffer;
+    LightClusters lightClusters;
+    OcclusionCuller occlusionCuller;
+    bool occlusionCulling;
+    std::vector<size_t> visibleObjects; // Scratch list reused by every culled pass
+    GLuint instanceVBO;
+    GLuint indirectBuffer;
+    std::vector<InstanceData> instanceData;
+    std::vector<DrawElementsIndirectCommand> drawCommands;
+    std::vector<size_t> drawCommandMaterials;       // Material of each entry of drawCommands
+    std::vector<size_t> drawCommandMeshes;          // Mesh of each entry of drawCommands
+    std::vector<GLuint> instanceCommands;           // Entry of drawCommands each instance belongs to
+    std::vector<CullInstance> cullInstances;
+    std::vector<size_t> materialMeshes;             // One mesh per material, to bind its textures
+    RenderQueue renderQueue;
+    LodSettings lodSettings;
+    std::vector<unsigned char> objectLods; // LOD picked for each visible object this pass
+
+    // What a culled pass looks through, for depth sorting and LOD selection
+    struct PassView {
+        glm::mat4 view;
+        glm::mat4 projection;
+        float maxDepth;
+        float viewportHeight; // Pixels
+        float pixelError;     // Largest acceptable LOD error on screen, bias applied
+    };
+
+    // Uniform handles resolved once after the programs link
+    Uniform<glm::mat4> geometryView, geometryProjection;
+    Uniform<glm::mat4> shadowLightSpaceMatrix;
+    Uniform<glm::mat4> shadowMaskCascadeMatrices[kShadowCascadeCount];
+    Uniform<float> shadowMaskCascadeSplits[kShadowCascadeCount];
+    Uniform<glm::vec3> shadowMaskLightDirection;
+    Uniform<glm::mat4> shadowMaskInverseView, shadowMaskInverseProjection;
+    Uniform<float> shadowMaskFrameRotation;
+    Uniform<bool> shadowMaskTemporal;
+    Uniform<glm::mat4> shadowMaskViewToPreviousClip, shadowMaskPreviousInverseProjection;
+    Uniform<glm::vec3> dirLightDirection, dirLightAmbient, dirLightDiffuse, dirLightSpecular;
+    Uniform<glm::mat4> lightingInverseView, lightingInverseProjection;
+    Uniform<glm::vec2> clusterTileSize;
+    Uniform<float> clusterSliceScale, clusterSliceBias;
+    Uniform<glm::vec3> lightingViewPos;
 
     void InitQuad();
-    void InitSSAO();
+    void InitUniforms();
+    void InitLightingUniforms();
+    void InitShadowMaskUniforms();
+    // Pick the smallest program variant that covers the scene's lights and the current settings.
+    // Selecting only issues the build; the pass resolves the uniform handles when it first uses the
+    // variant, so every variant a frame needs compiles in parallel before anything waits on one.
+    void SelectLightingVariant();
+    void SelectShadowMaskVariant();
     void InitShadowMap();
+    void AllocateShadowMaskTargets();
+    void DeleteShadowMaskTargets();
+    void DrawVisibleObjects(const Scene& scene, unsigned int pass, const PassView& passView);
+    // Geometry pass variant: the visible objects are further culled on the GPU in two Hi-Z phases
+    void DrawOcclusionCulledObjects(const Scene& scene, Shader& shader, const PassView& passView);
+    // Sorts the visible objects and fills instanceData and drawCommands from them
+    void BuildDrawCommands(const Scene& scene, unsigned int pass, const PassView& passView);
+    // Issues drawCommands from the bound indirect buffer, starting commandOffset entries in.
+    // Without bindTextures (depth-only passes) material changes do not split the multi-draws.
+    void SubmitDrawCommands(const Scene& scene, GLuint instanceBuffer, size_t commandOffset, bool bindTextures);
+    unsigned int SelectLod(const Mesh& mesh, const Scene::SceneObject& object, const PassView& passView, float depth) const;
     void GeometryPass(GLuint vao, int vertexCount, Camera& camera, const Scene& scene);
-    void SSAOPass(Camera& camera);
+    void SSAOPass();
+    // Filters the directional light's soft shadow into shadowMaskTextures, accumulated over frames
+    void ShadowMaskPass(const Scene& scene);
+    void LightCullingPass(const Camera& camera);
     void LightingPass(const Camera& camera, const Scene& scene);
-    void ShadowPass(const Scene& scene);
+    void ShadowPass(const Camera& camera, const Scene& scene);
+    // True if a static caster was added to, moved in or out of, or changed within the cached layer
+    bool StaticCastersChanged(const Scene& scene, const ShadowCache& cache) const;
 };
 
 #endif // RENDERER_H
@@ -0,0 +1,290 @@
+#include "SSAO.h"
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+namespace {
+
+GLuint CreateTarget(GLenum internalFormat, GLenum format, GLenum type, int width, int height) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+GLuint CreateFramebuffer(GLuint colorTexture) {
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "SSAO framebuffer not complete!" << std::endl;
+    }
+    return fbo;
+}
+
+void DrawQuad(GLuint quadVAO) {
+    glBindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+}
+
+} // namespace
+
+SSAO::SSAO(int width, int height)
+    : width(width), height(height), lowWidth(0), lowHeight(0),
+    downsampleShader("ssao.vert", "ssao_downsample.frag"),
+    occlusionShader("ssao.vert", "ssao.frag"),
+    blurShader("ssao.vert", "ssao_blur.frag"),
+    upsampleShader("ssao.vert", "ssao_upsample.frag"),
+    historyIndex(0), historyValid(false), uniformsResolved(false) {
+    AllocateTargets();
+
+    // Random rotations tiled over the screen, so the kernel only needs a few samples per pixel
+    std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0);
+    std::default_random_engine generator;
+    std::vector<glm::vec3> noise;
+    for (unsigned int i = 0; i < 16; i++) {
+        noise.push_back(glm::vec3(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, 0.0f));
+    }
+    glGenTextures(1, &noiseTexture);
+    glBindTexture(GL_TEXTURE_2D, noiseTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, 4, 4, 0, GL_RGB, GL_FLOAT, &noise[0]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenBuffers(1, &kernelBuffer);
+    UploadKernel();
+}
+
+SSAO::~SSAO() {
+    DeleteTargets();
+    glDeleteTextures(1, &noiseTexture);
+    glDeleteBuffers(1, &kernelBuffer);
+}
+
+void SSAO::Resize(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    DeleteTargets();
+    AllocateTargets();
+}
+
+void SSAO::SetSettings(const SSAOSettings& newSettings) {
+    SSAOSettings previous = settings;
+    settings = newSettings;
+    settings.resolutionDivisor = std::max(1, settings.resolutionDivisor);
+    settings.sampleCount = std::min(std::max(1, settings.sampleCount), kMaxSamples);
+
+    if (settings.resolutionDivisor != previous.resolutionDivisor) {
+        DeleteTargets();
+        AllocateTargets();
+    }
+    if (settings.sampleCount != previous.sampleCount) {
+        UploadKernel();
+    }
+    if (!settings.enabled) {
+        historyValid = false; // Nothing is rendered, so the history goes stale
+    }
+}
+
+void SSAO::AllocateTargets() {
+    lowWidth = std::max(1, (width + settings.resolutionDivisor - 1) / settings.resolutionDivisor);
+    lowHeight = std::max(1, (height + settings.resolutionDivisor - 1) / settings.resolutionDivisor);
+
+    depthTexture = CreateTarget(GL_R32F, GL_RED, GL_FLOAT, lowWidth, lowHeight);
+    normalTexture = CreateTarget(GL_RG16, GL_RG, GL_UNSIGNED_SHORT, lowWidth, lowHeight);
+    downsampleFBO = CreateFramebuffer(depthTexture);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+    GLenum attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, attachments);
+
+    for (int i = 0; i < 2; ++i) {
+        occlusionTextures[i] = CreateTarget(GL_RG16F, GL_RG, GL_FLOAT, lowWidth, lowHeight);
+        occlusionFBOs[i] = CreateFramebuffer(occlusionTextures[i]);
+    }
+    historyDepthTexture = CreateTarget(GL_R32F, GL_RED, GL_FLOAT, lowWidth, lowHeight);
+    historyValid = false;
+    blurTempTexture = CreateTarget(GL_R8, GL_RED, GL_UNSIGNED_BYTE, lowWidth, lowHeight);
+    blurFBO = CreateFramebuffer(blurTempTexture);
+    blurredTexture = CreateTarget(GL_R8, GL_RED, GL_UNSIGNED_BYTE, lowWidth, lowHeight);
+    blurredFBO = CreateFramebuffer(blurredTexture);
+    upsampledTexture = CreateTarget(GL_R8, GL_RED, GL_UNSIGNED_BYTE, width, height);
+    upsampleFBO = CreateFramebuffer(upsampledTexture);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void SSAO::DeleteTargets() {
+    GLuint textures[] = { depthTexture, normalTexture, occlusionTextures[0], occlusionTextures[1], historyDepthTexture,
+        blurTempTexture, blurredTexture, upsampledTexture };
+    GLuint framebuffers[] = { downsampleFBO, occlusionFBOs[0], occlusionFBOs[1], blurFBO, blurredFBO, upsampleFBO };
+    glDeleteTextures(8, textures);
+    glDeleteFramebuffers(6, framebuffers);
+}
+
+void SSAO::UploadKernel() {
+    // Samples in the +z hemisphere, packed towards the origin so close occluders count most
+    std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0);
+    std::default_random_engine generator;
+    std::vector<glm::vec4> kernel(kMaxSamples, glm::vec4(0.0f));
+    for (int i = 0; i < settings.sampleCount; ++i) {
+        glm::vec3 sample(
+            randomFloats(generator) * 2.0 - 1.0,
+            randomFloats(generator) * 2.0 - 1.0,
+            randomFloats(generator)
+        );
+        sample = glm::normalize(sample);
+        sample *= randomFloats(generator);
+        float scale = float(i) / float(settings.sampleCount);
+        scale = 0.1f + scale * scale * (1.0f - 0.1f);
+        kernel[i] = glm::vec4(sample * scale, 0.0f);
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, kernelBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, kernel.size() * sizeof(glm::vec4), kernel.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void SSAO::Render(const CameraHistory& camera, const GBuffer& gbuffer, GLuint quadVAO, Profiler& profiler) {
+    ResolveUniforms();
+    const glm::mat4& projection = camera.projection;
+    glm::mat4 inverseProjection = glm::inverse(projection);
+    glViewport(0, 0, lowWidth, lowHeight);
+
+    profiler.BeginScope("SSAODownsample");
+    glBindFramebuffer(GL_FRAMEBUFFER, downsampleFBO);
+    downsampleShader.use();
+    downsampleShader.set(downsampleInverseProjection, inverseProjection);
+    downsampleShader.set(downsampleView, camera.view);
+    downsampleShader.set(downsampleDivisor, settings.resolutionDivisor);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, gbuffer.GetDepthTexture());
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, gbuffer.GetNormalTexture());
+    DrawQuad(quadVAO);
+    profiler.EndScope();
+
+    profiler.BeginScope("SSAO");
+    // Last frame's output is only usable if it was rendered into these targets with a camera to reproject from
+    bool temporal = settings.temporal && historyValid && camera.hasPrevious;
+    historyIndex = 1 - historyIndex;
+    GLuint occlusionTexture = occlusionTextures[historyIndex];
+    glBindFramebuffer(GL_FRAMEBUFFER, occlusionFBOs[historyIndex]);
+    occlusionShader.use();
+    occlusionShader.set(occlusionProjection, projection);
+    // View-space position = (ndc.xy * viewRayScale * depth, -depth) for a symmetric perspective
+    occlusionShader.set(occlusionViewRayScale, glm::vec2(1.0f / projection[0][0], 1.0f / projection[1][1]));
+    occlusionShader.set(occlusionNoiseScale, glm::vec2(lowWidth / 4.0f, lowHeight / 4.0f));
+    occlusionShader.set(occlusionSampleCount, settings.sampleCount);
+    occlusionShader.set(occlusionRadius, settings.radius);
+    occlusionShader.set(occlusionBias, settings.bias);
+    occlusionShader.set(occlusionFrameRotation, settings.temporal ? camera.GetFrameRotation() : 0.0f);
+    occlusionShader.set(occlusionTemporal, temporal);
+    occlusionShader.set(occlusionViewToPreviousClip, camera.GetViewToPreviousClip());
+    glBindBufferBase(GL_UNIFORM_BUFFER, kKernelBinding, kernelBuffer);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, normalTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, noiseTexture);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, occlusionTextures[1 - historyIndex]);
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, historyDepthTexture);
+    DrawQuad(quadVAO);
+
+    // This frame's depth is what next frame reprojects against
+    glCopyImageSubData(depthTexture, GL_TEXTURE_2D, 0, 0, 0, 0, historyDepthTexture, GL_TEXTURE_2D, 0, 0, 0, 0, lowWidth, lowHeight, 1);
+    historyValid = true;
+    profiler.EndScope();
+
+    profiler.BeginScope("SSAOBlur");
+    blurShader.use();
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, normalTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindFramebuffer(GL_FRAMEBUFFER, blurFBO);
+    blurShader.set(blurDirection, glm::vec2(1.0f, 0.0f));
+    glBindTexture(GL_TEXTURE_2D, occlusionTexture);
+    DrawQuad(quadVAO);
+    glBindFramebuffer(GL_FRAMEBUFFER, blurredFBO);
+    blurShader.set(blurDirection, glm::vec2(0.0f, 1.0f));
+    glBindTexture(GL_TEXTURE_2D, blurTempTexture);
+    DrawQuad(quadVAO);
+    profiler.EndScope();
+
+    glViewport(0, 0, width, height);
+    if (settings.resolutionDivisor > 1) {
+        profiler.BeginScope("SSAOUpsample");
+        glBindFramebuffer(GL_FRAMEBUFFER, upsampleFBO);
+        upsampleShader.use();
+        upsampleShader.set(upsampleInverseProjection, inverseProjection);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, blurredTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, gbuffer.GetDepthTexture());
+        DrawQuad(quadVAO);
+        profiler.EndScope();
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void SSAO::ResolveUniforms() {
+    if (uniformsResolved)
+        return;
+    downsampleInverseProjection = downsampleShader.getUniform<glm::mat4>("inverseProjection");
+    downsampleView = downsampleShader.getUniform<glm::mat4>("view");
+    downsampleDivisor = downsampleShader.getUniform<int>("divisor");
+    occlusionProjection = occlusionShader.getUniform<glm::mat4>("projection");
+    occlusionViewRayScale = occlusionShader.getUniform<glm::vec2>("viewRayScale");
+    occlusionNoiseScale = occlusionShader.getUniform<glm::vec2>("noiseScale");
+    occlusionSampleCount = occlusionShader.getUniform<int>("sampleCount");
+    occlusionRadius = occlusionShader.getUniform<float>("radius");
+    occlusionBias = occlusionShader.getUniform<float>("bias");
+    occlusionFrameRotation = occlusionShader.getUniform<float>("frameRotation");
+    occlusionTemporal = occlusionShader.getUniform<bool>("temporal");
+    occlusionViewToPreviousClip = occlusionShader.getUniform<glm::mat4>("viewToPreviousClip");
+    blurDirection = blurShader.getUniform<glm::vec2>("direction");
+    upsampleInverseProjection = upsampleShader.getUniform<glm::mat4>("inverseProjection");
+
+    // Sampler units and the kernel block binding never change
+    downsampleShader.use();
+    downsampleShader.setInt("gDepth", 0);
+    downsampleShader.setInt("gNormal", 1);
+    occlusionShader.use();
+    occlusionShader.setInt("viewDepth", 0);
+    occlusionShader.setInt("viewNormal", 1);
+    occlusionShader.setInt("texNoise", 2);
+    occlusionShader.setInt("history", 3);
+    occlusionShader.setInt("historyDepth", 4);
+    GLuint kernelBlock = glGetUniformBlockIndex(occlusionShader.ID, "SSAOKernel");
+    if (kernelBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(occlusionShader.ID, kernelBlock, kKernelBinding);
+    }
+    blurShader.use();
+    blurShader.setInt("ssaoInput", 0);
+    blurShader.setInt("viewDepth", 1);
+    blurShader.setInt("viewNormal", 2);
+    upsampleShader.use();
+    upsampleShader.setInt("ssaoInput", 0);
+    upsampleShader.setInt("viewDepth", 1);
+    upsampleShader.setInt("gDepth", 2);
+    glUseProgram(0);
+    uniformsResolved = true;
+}
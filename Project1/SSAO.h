@@ -0,0 +1,95 @@
+#ifndef SSAO_H
+#define SSAO_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "Shader.h"
+#include "GBuffer.h"
+#include "Camera.h"
+#include "Profiler.h"
+
+struct SSAOSettings {
+    bool enabled = true;       // Off skips the passes and the lighting pass's occlusion lookup
+    int resolutionDivisor = 2; // 1 = full, 2 = half, 4 = quarter resolution
+    int sampleCount = 8;       // Kernel samples per pixel per frame, at most SSAO::kMaxSamples
+    float radius = 0.5f;       // View-space hemisphere radius
+    float bias = 0.025f;
+    bool temporal = true;      // Accumulate over frames; without it sampleCount must be 4-8x higher to converge
+};
+
+// Screen-space ambient occlusion at a fraction of the screen resolution:
+//   downsample - keeps the nearest of each block's G-buffer samples as linear view depth and a view-space normal
+//   occlusion  - hemisphere kernel (stored once in a uniform buffer) against the downsampled depth, its noise
+//                rotated every frame and blended with last frame's result where that reprojects onto the same surface
+//   blur       - separable bilateral filter that does not bleed across depth or normal edges
+//   upsample   - joint bilateral upsample to full resolution, guided by the full-resolution depth
+class SSAO {
+public:
+    static const int kMaxSamples = 64;
+    static const GLuint kKernelBinding = 0; // Uniform buffer binding of the kernel block
+
+    SSAO(int width, int height);
+    ~SSAO();
+
+    void Resize(int newWidth, int newHeight);
+    // Reallocates the low-resolution targets or regenerates the kernel only when those settings change
+    void SetSettings(const SSAOSettings& newSettings);
+    const SSAOSettings& GetSettings() const { return settings; }
+
+    // Leaves the viewport at the full resolution and framebuffer 0 bound
+    void Render(const CameraHistory& camera, const GBuffer& gbuffer, GLuint quadVAO, Profiler& profiler);
+
+    // Full-resolution occlusion for the lighting pass, 1 = unoccluded
+    GLuint GetOcclusionTexture() const { return settings.resolutionDivisor > 1 ? upsampledTexture : blurredTexture; }
+
+private:
+    int width;
+    int height;
+    int lowWidth;
+    int lowHeight;
+    SSAOSettings settings;
+
+    Shader downsampleShader;
+    Shader occlusionShader;
+    Shader blurShader;
+    Shader upsampleShader;
+
+    GLuint downsampleFBO;
+    GLuint depthTexture;   // R32F linear view depth, low resolution
+    GLuint normalTexture;  // RG16 octahedral view-space normal, low resolution
+    GLuint occlusionFBOs[2];
+    GLuint occlusionTextures[2]; // RG16F occlusion and frames accumulated; written alternately, the other is the history
+    GLuint historyDepthTexture;  // depthTexture as of the last frame
+    int historyIndex;            // Which of occlusionTextures this frame writes
+    bool historyValid;           // False until a frame has been rendered into freshly allocated targets
+    bool uniformsResolved;
+    GLuint blurFBO;        // Horizontal blur target; the vertical pass writes back into blurredTexture
+    GLuint blurTempTexture;
+    GLuint blurredFBO;
+    GLuint blurredTexture;
+    GLuint upsampleFBO;
+    GLuint upsampledTexture;
+    GLuint noiseTexture;
+    GLuint kernelBuffer;
+
+    Uniform<glm::mat4> downsampleInverseProjection, downsampleView;
+    Uniform<int> downsampleDivisor;
+    Uniform<glm::mat4> occlusionProjection;
+    Uniform<glm::vec2> occlusionViewRayScale, occlusionNoiseScale;
+    Uniform<int> occlusionSampleCount;
+    Uniform<float> occlusionRadius, occlusionBias;
+    Uniform<float> occlusionFrameRotation;
+    Uniform<bool> occlusionTemporal;
+    Uniform<glm::mat4> occlusionViewToPreviousClip;
+    Uniform<glm::vec2> blurDirection;
+    Uniform<glm::mat4> upsampleInverseProjection;
+
+    void AllocateTargets();
+    void DeleteTargets();
+    void UploadKernel();
+    // Deferred to the first Render so the four programs link while the renderer issues its others
+    void ResolveUniforms();
+};
+
+#endif // SSAO_H
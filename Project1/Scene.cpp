@@ -1,7 +1,68 @@
-#include "scene.h"
+#include "Scene.h"
+#include "RenderQueue.h"
+#include <iostream>
+
+size_t Scene::AddMesh(const Mesh& mesh) {
+    size_t material = materialCount;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        if (meshes[i].HasSameTextures(mesh)) {
+            material = meshMaterials[i];
+            break;
+        }
+    }
+    if (material == materialCount) {
+        ++materialCount;
+        if (materialCount == RenderQueue::kMaxMaterial + 2) {
+            std::cerr << "Scene has more than " << RenderQueue::kMaxMaterial + 1
+                << " materials; the rest will not be grouped when sorting draws" << std::endl;
+        }
+    }
 
-void Scene::AddMesh(const Mesh& mesh) {
     meshes.push_back(mesh);
+    meshMaterials.push_back(material);
+    return meshes.size() - 1;
+}
+
+size_t Scene::AddObject(size_t meshIndex, const glm::mat4& transform) {
+    SceneObject object;
+    object.mesh = meshIndex;
+    object.transform = transform;
+    object.worldBounds = meshes[meshIndex].GetBounds().Transformed(transform);
+    object.proxy = bvh.Insert(object.worldBounds, objects.size());
+    object.revision = ++revision;
+    object.dynamic = false;
+    objects.push_back(object);
+    return objects.size() - 1;
+}
+
+size_t Scene::AddInstances(size_t meshIndex, const std::vector<glm::mat4>& transforms) {
+    size_t first = objects.size();
+    objects.reserve(objects.size() + transforms.size());
+    for (const auto& transform : transforms) {
+        AddObject(meshIndex, transform);
+    }
+    return first;
+}
+
+void Scene::SetObjectTransform(size_t index, const glm::mat4& transform) {
+    SceneObject& object = objects[index];
+    object.transform = transform;
+    object.worldBounds = meshes[object.mesh].GetBounds().Transformed(transform);
+    bvh.Move(object.proxy, object.worldBounds);
+    object.revision = ++revision;
+}
+
+void Scene::SetObjectDynamic(size_t index, bool dynamic) {
+    SceneObject& object = objects[index];
+    if (object.dynamic != dynamic) {
+        object.dynamic = dynamic;
+        object.revision = ++revision;
+    }
+}
+
+void Scene::CullObjects(const Frustum& frustum, std::vector<size_t>& visibleObjects) const {
+    visibleObjects.clear();
+    bvh.Query(frustum, visibleObjects);
 }
 
 void Scene::SetDirectionalLight(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular) {
@@ -10,12 +71,30 @@ void Scene::SetDirectionalLight(const glm::vec3& position, const glm::vec3& dire
     directionalLight.ambient = ambient;
     directionalLight.diffuse = diffuse;
     directionalLight.specular = specular;
+    directionalLightRevision = ++revision;
 }
 
 void Scene::AddPointLight(const glm::vec3& position, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular, float constant, float linear, float quadratic) {
     pointLights.push_back({ position, ambient, diffuse, specular, constant, linear, quadratic });
+    pointLightsDirty.add(pointLights.size() - 1, pointLights.size());
 }
 
 void Scene::AddSpotLight(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular, float constant, float linear, float quadratic, float cutOff, float outerCutOff) {
     spotLights.push_back({ position, direction, ambient, diffuse, specular, constant, linear, quadratic, cutOff, outerCutOff });
+    spotLightsDirty.add(spotLights.size() - 1, spotLights.size());
+}
+
+void Scene::UpdatePointLight(size_t index, const PointLight& light) {
+    pointLights[index] = light;
+    pointLightsDirty.add(index, index + 1);
+}
+
+void Scene::UpdateSpotLight(size_t index, const SpotLight& light) {
+    spotLights[index] = light;
+    spotLightsDirty.add(index, index + 1);
+}
+
+void Scene::ClearLightDirtyRanges() {
+    pointLightsDirty.clear();
+    spotLightsDirty.clear();
 }
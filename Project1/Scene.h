@@ -1,27 +1,20 @@
 #ifndef SCENE_H
 #define SCENE_H
 
-#include "gbuffer.h"
-#include "shader.h"
-#include "camera.h"
-#include "mesh.h"
+#include "GBuffer.h"
+#include "Shader.h"
+#include "Camera.h"
+#include "Mesh.h"
+#include "Bounds.h"
+#include "BVH.h"
+#include "Frustum.h"
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
 class Scene {
 public:
-    void AddMesh(const Mesh& mesh);
-    void SetDirectionalLight(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular);
-    void AddPointLight(const glm::vec3& position, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular, float constant, float linear, float quadratic);
-    void AddSpotLight(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular, float constant, float linear, float quadratic, float cutOff, float outerCutOff);
-
-    const auto& GetMeshes() const { return meshes; }
-    const auto& GetDirectionalLight() const { return directionalLight; }
-    const auto& GetPointLights() const { return pointLights; }
-    const auto& GetSpotLights() const { return spotLights; }
-
-private:
-    std::vector<Mesh> meshes;
     struct DirectionalLight {
         glm::vec3 position;   // Add position
         glm::vec3 direction;
@@ -51,9 +44,80 @@ private:
         float outerCutOff;
     };
 
+    // Half-open range of light indices modified since the renderer last uploaded them
+    struct DirtyRange {
+        size_t begin = 0;
+        size_t end = 0;
+
+        bool empty() const { return begin >= end; }
+        void add(size_t first, size_t last) {
+            begin = empty() ? first : std::min(begin, first);
+            end = std::max(end, last);
+        }
+        void clear() { begin = end = 0; }
+    };
+
+    // A placed instance of one of the scene's meshes
+    struct SceneObject {
+        size_t mesh;
+        glm::mat4 transform;
+        AABB worldBounds;
+        int proxy; // Leaf in the scene BVH
+        uint64_t revision; // Scene revision of the object's last change
+        bool dynamic;      // Redrawn into the shadow maps every frame instead of cached with static geometry
+    };
+
+    // Returns the index to pass to AddObject
+    size_t AddMesh(const Mesh& mesh);
+    size_t AddObject(size_t meshIndex, const glm::mat4& transform = glm::mat4(1.0f));
+    // Places one object per transform; returns the index of the first. Objects sharing a mesh
+    // are drawn with a single instanced call per pass.
+    size_t AddInstances(size_t meshIndex, const std::vector<glm::mat4>& transforms);
+    void SetObjectTransform(size_t index, const glm::mat4& transform);
+    // Objects are static by default; mark the ones that move often so they do not keep
+    // invalidating the static shadow cache
+    void SetObjectDynamic(size_t index, bool dynamic);
+    void SetDirectionalLight(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular);
+    void AddPointLight(const glm::vec3& position, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular, float constant, float linear, float quadratic);
+    void AddSpotLight(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular, float constant, float linear, float quadratic, float cutOff, float outerCutOff);
+    void UpdatePointLight(size_t index, const PointLight& light);
+    void UpdateSpotLight(size_t index, const SpotLight& light);
+
+    const auto& GetMeshes() const { return meshes; }
+    const auto& GetObjects() const { return objects; }
+    // Meshes binding the same textures share a material id
+    size_t GetMeshMaterial(size_t meshIndex) const { return meshMaterials[meshIndex]; }
+    const auto& GetDirectionalLight() const { return directionalLight; }
+    const auto& GetPointLights() const { return pointLights; }
+    const auto& GetSpotLights() const { return spotLights; }
+
+    // Incremented by every change to an object or the directional light; the changed thing is
+    // stamped with the new value, so caches built at revision R are stale for anything stamped above R
+    uint64_t GetRevision() const { return revision; }
+    uint64_t GetDirectionalLightRevision() const { return directionalLightRevision; }
+
+    const DirtyRange& GetPointLightDirtyRange() const { return pointLightsDirty; }
+    const DirtyRange& GetSpotLightDirtyRange() const { return spotLightsDirty; }
+    void ClearLightDirtyRanges();
+
+    // Replaces visibleObjects with the indices of the objects whose bounds touch the frustum
+    void CullObjects(const Frustum& frustum, std::vector<size_t>& visibleObjects) const;
+
+private:
+    std::vector<Mesh> meshes;
+    std::vector<SceneObject> objects;
+    std::vector<size_t> meshMaterials;
+    size_t materialCount = 0;
+    BVH bvh;
+
+    uint64_t revision = 0;
+    uint64_t directionalLightRevision = 0;
+
     DirectionalLight directionalLight;
     std::vector<PointLight> pointLights;
     std::vector<SpotLight> spotLights;
+    DirtyRange pointLightsDirty;
+    DirtyRange spotLightsDirty;
 };
 
 #endif // SCENE_H
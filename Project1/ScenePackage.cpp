@@ -0,0 +1,181 @@
+#include "ScenePackage.h"
+#include <cstring>
+#include <iostream>
+
+static_assert(sizeof(Vertex) == sizeof(PackageVertex), "PackageVertex must mirror Vertex");
+static_assert(sizeof(MeshLod) == sizeof(PackageLod) && kMaxMeshLods == kPackageMaxLods, "PackageLod must mirror MeshLod");
+
+namespace {
+
+bool RangeInFile(uint64_t offset, uint64_t size, uint64_t fileSize) {
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+bool IsAligned(uint64_t offset) {
+    return offset % kScenePackageAlignment == 0;
+}
+
+glm::vec3 ToVec3(const float* values) {
+    return glm::vec3(values[0], values[1], values[2]);
+}
+
+} // namespace
+
+ScenePackage::ScenePackage() : header(nullptr) {}
+
+bool ScenePackage::Open(const std::string& path) {
+    Close();
+    if (!file.Open(path)) {
+        std::cerr << "Failed to open scene package: " << path << std::endl;
+        return false;
+    }
+
+    header = At<PackageHeader>(0);
+    if (!Validate(path)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void ScenePackage::Close() {
+    file.Close();
+    header = nullptr;
+}
+
+bool ScenePackage::Validate(const std::string& path) const {
+    uint64_t size = file.GetSize();
+    if (size < sizeof(PackageHeader) || header->magic != kScenePackageMagic) {
+        std::cerr << "Not a scene package: " << path << std::endl;
+        return false;
+    }
+    if (header->version != kScenePackageVersion || header->vertexSize != sizeof(PackageVertex)) {
+        std::cerr << "Scene package " << path << " is version " << header->version << ", expected "
+            << kScenePackageVersion << "; re-run ScenePacker" << std::endl;
+        return false;
+    }
+    if (header->fileSize != size) {
+        std::cerr << "Scene package is truncated: " << path << std::endl;
+        return false;
+    }
+
+    struct Table { uint64_t offset; uint64_t bytes; };
+    const Table tables[] = {
+        { header->meshTableOffset, (uint64_t)header->meshCount * sizeof(PackageMesh) },
+        { header->textureTableOffset, (uint64_t)header->textureCount * sizeof(PackageTexture) },
+        { header->objectTableOffset, (uint64_t)header->objectCount * sizeof(PackageObject) },
+        { header->lightTableOffset, (uint64_t)header->lightCount * sizeof(PackageLight) },
+        { header->stringTableOffset, header->stringBytes },
+    };
+    for (const Table& table : tables) {
+        if (!IsAligned(table.offset) || !RangeInFile(table.offset, table.bytes, size)) {
+            std::cerr << "Scene package has a corrupt table: " << path << std::endl;
+            return false;
+        }
+    }
+
+    // Every string must be terminated inside the table
+    if (header->stringBytes > 0 && GetString(header->stringBytes - 1)[0] != '\0') {
+        std::cerr << "Scene package has a corrupt string table: " << path << std::endl;
+        return false;
+    }
+
+    const PackageMesh* meshes = At<PackageMesh>(header->meshTableOffset);
+    for (uint32_t i = 0; i < header->meshCount; ++i) {
+        const PackageMesh& mesh = meshes[i];
+        if (!IsAligned(mesh.vertexOffset) || !IsAligned(mesh.indexOffset) ||
+            !RangeInFile(mesh.vertexOffset, (uint64_t)mesh.vertexCount * sizeof(PackageVertex), size) ||
+            !RangeInFile(mesh.indexOffset, (uint64_t)mesh.indexCount * sizeof(uint32_t), size) ||
+            (uint64_t)mesh.firstTexture + mesh.textureCount > header->textureCount ||
+            (mesh.indexCount > 0 && mesh.maxIndex >= mesh.vertexCount) ||
+            mesh.lodCount == 0 || mesh.lodCount > kPackageMaxLods) {
+            std::cerr << "Scene package has a corrupt mesh " << i << ": " << path << std::endl;
+            return false;
+        }
+        for (uint32_t lod = 0; lod < mesh.lodCount; ++lod) {
+            if ((uint64_t)mesh.lods[lod].firstIndex + mesh.lods[lod].indexCount > mesh.indexCount) {
+                std::cerr << "Scene package has a corrupt LOD in mesh " << i << ": " << path << std::endl;
+                return false;
+            }
+        }
+    }
+
+    const PackageTexture* textures = At<PackageTexture>(header->textureTableOffset);
+    for (uint32_t i = 0; i < header->textureCount; ++i) {
+        if (textures[i].pathOffset >= header->stringBytes || textures[i].typeOffset >= header->stringBytes) {
+            std::cerr << "Scene package has a corrupt texture " << i << ": " << path << std::endl;
+            return false;
+        }
+    }
+
+    const PackageObject* objects = At<PackageObject>(header->objectTableOffset);
+    for (uint32_t i = 0; i < header->objectCount; ++i) {
+        if (objects[i].mesh >= header->meshCount) {
+            std::cerr << "Scene package object " << i << " has no mesh: " << path << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void ScenePackage::Load(Scene& scene, TextureManager& textureManager) const {
+    const PackageMesh* meshes = At<PackageMesh>(header->meshTableOffset);
+    const PackageTexture* textures = At<PackageTexture>(header->textureTableOffset);
+    const PackageObject* objects = At<PackageObject>(header->objectTableOffset);
+    const PackageLight* lights = At<PackageLight>(header->lightTableOffset);
+
+    // Package mesh i becomes scene mesh firstMesh + i
+    size_t firstMesh = scene.GetMeshes().size();
+    std::vector<Texture> meshTextures;
+    for (uint32_t i = 0; i < header->meshCount; ++i) {
+        const PackageMesh& packaged = meshes[i];
+
+        meshTextures.clear();
+        for (uint32_t t = 0; t < packaged.textureCount; ++t) {
+            const PackageTexture& texture = textures[packaged.firstTexture + t];
+            meshTextures.push_back(textureManager.Acquire(GetString(texture.pathOffset), GetString(texture.typeOffset)));
+        }
+
+        BoundingSphere sphere;
+        sphere.center = ToVec3(packaged.sphere);
+        sphere.radius = packaged.sphere[3];
+        std::vector<MeshLod> lods(packaged.lodCount);
+        std::memcpy(lods.data(), packaged.lods, packaged.lodCount * sizeof(PackageLod));
+
+        Mesh mesh(At<Vertex>(packaged.vertexOffset), packaged.vertexCount,
+            At<unsigned int>(packaged.indexOffset), packaged.indexCount,
+            meshTextures, AABB(ToVec3(packaged.boundsMin), ToVec3(packaged.boundsMax)), sphere, lods);
+        scene.AddMesh(mesh);
+    }
+
+    for (uint32_t i = 0; i < header->objectCount; ++i) {
+        glm::mat4 transform;
+        std::memcpy(&transform, objects[i].transform, sizeof(objects[i].transform));
+        scene.AddObject(firstMesh + objects[i].mesh, transform);
+    }
+
+    for (uint32_t i = 0; i < header->lightCount; ++i) {
+        const PackageLight& light = lights[i];
+        glm::vec3 position = ToVec3(light.position);
+        glm::vec3 direction = ToVec3(light.direction);
+        glm::vec3 ambient = ToVec3(light.ambient);
+        glm::vec3 diffuse = ToVec3(light.diffuse);
+        glm::vec3 specular = ToVec3(light.specular);
+
+        switch (light.type) {
+        case kPackageDirectionalLight:
+            scene.SetDirectionalLight(position, direction, ambient, diffuse, specular);
+            break;
+        case kPackagePointLight:
+            scene.AddPointLight(position, ambient, diffuse, specular, light.constant, light.linear, light.quadratic);
+            break;
+        case kPackageSpotLight:
+            scene.AddSpotLight(position, direction, ambient, diffuse, specular, light.constant, light.linear, light.quadratic,
+                light.cutOff, light.outerCutOff);
+            break;
+        default:
+            std::cerr << "Skipping scene package light " << i << " of unknown type " << light.type << std::endl;
+            break;
+        }
+    }
+}
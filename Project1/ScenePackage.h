@@ -0,0 +1,37 @@
+#ifndef SCENEPACKAGE_H
+#define SCENEPACKAGE_H
+
+#include <string>
+#include "MappedFile.h"
+#include "ScenePackageFormat.h"
+#include "Scene.h"
+#include "TextureManager.h"
+
+// A .gspk scene package mapped into memory. Open only validates the header and tables; Load
+// then creates the meshes by uploading their vertex and index blobs straight from the mapping,
+// so nothing is parsed or copied through intermediate buffers on the way to the GPU.
+class ScenePackage {
+public:
+    ScenePackage();
+
+    bool Open(const std::string& path);
+    void Close();
+
+    // Adds every mesh, object and light in the package to the scene.
+    // Textures are requested from textureManager and stream in asynchronously.
+    void Load(Scene& scene, TextureManager& textureManager) const;
+
+    const PackageHeader& GetHeader() const { return *header; }
+
+private:
+    MappedFile file;
+    const PackageHeader* header;
+
+    template <typename T>
+    const T* At(uint64_t offset) const { return reinterpret_cast<const T*>(file.GetData() + offset); }
+    const char* GetString(uint32_t offset) const { return At<char>(header->stringTableOffset + offset); }
+
+    bool Validate(const std::string& path) const;
+};
+
+#endif // SCENEPACKAGE_H
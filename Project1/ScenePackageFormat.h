@@ -0,0 +1,93 @@
+#ifndef SCENEPACKAGEFORMAT_H
+#define SCENEPACKAGEFORMAT_H
+
+#include <cstdint>
+
+// On-disk layout of a .gspk scene package, written by ScenePacker and mapped directly by
+// ScenePackage. Every table and blob starts on a kScenePackageAlignment boundary so the mapping
+// can be read in place and handed to glBufferSubData without copying. Offsets are from the
+// start of the file. Bump kScenePackageVersion whenever a record or the Vertex layout changes.
+
+const uint32_t kScenePackageMagic = 0x4B505347; // "GSPK"
+const uint32_t kScenePackageVersion = 3;
+const uint32_t kPackageMaxLods = 4;
+const uint32_t kScenePackageAlignment = 16;
+
+// Same layout as Vertex in mesh.h, so the tools don't need GL headers to write one
+struct PackageVertex {
+    float position[3];
+    float normal[3];
+    float texCoords[2];
+};
+
+struct PackageHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexSize;     // sizeof(PackageVertex) the package was built with
+    uint32_t meshCount;
+    uint32_t textureCount;
+    uint32_t objectCount;
+    uint32_t lightCount;
+    uint32_t stringBytes;
+    uint64_t meshTableOffset;
+    uint64_t textureTableOffset;
+    uint64_t objectTableOffset;
+    uint64_t lightTableOffset;
+    uint64_t stringTableOffset;
+    uint64_t fileSize;
+};
+
+// Range of a mesh's index blob holding one level of detail
+struct PackageLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;             // Object-space, see MeshLod
+};
+
+struct PackageMesh {
+    uint64_t vertexOffset;   // Blob of vertexCount Vertex records
+    uint64_t indexOffset;    // Blob of indexCount uint32 indices: every LOD back to back
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t maxIndex;       // Largest index in the blob, checked against vertexCount on load
+    uint32_t firstTexture;   // Range in the texture table
+    uint32_t textureCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    float sphere[4];         // Center and radius, so loading never walks the vertices
+    uint32_t lodCount;
+    PackageLod lods[kPackageMaxLods];
+};
+
+struct PackageTexture {
+    uint32_t pathOffset;     // NUL-terminated strings in the string table
+    uint32_t typeOffset;
+};
+
+struct PackageObject {
+    uint32_t mesh;
+    uint32_t padding[3];
+    float transform[16];     // Column-major, like glm::mat4
+};
+
+enum PackageLightType : uint32_t {
+    kPackageDirectionalLight = 0,
+    kPackagePointLight = 1,
+    kPackageSpotLight = 2,
+};
+
+struct PackageLight {
+    uint32_t type;
+    float position[3];
+    float direction[3];
+    float ambient[3];
+    float diffuse[3];
+    float specular[3];
+    float constant;
+    float linear;
+    float quadratic;
+    float cutOff;            // Cosines, as Scene stores them
+    float outerCutOff;
+};
+
+#endif // SCENEPACKAGEFORMAT_H
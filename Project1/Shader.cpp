@@ -1,89 +1,234 @@
-#include "shader.h"
+#include "Shader.h"
+#include "ShaderCache.h"
 #include <glm/gtc/type_ptr.hpp>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
+namespace {
+
+// #version has to stay the first line, so the defines go right after it
+std::string InsertDefines(const std::string& source, const std::string& defines) {
+    if (defines.empty())
+        return source;
+    std::string block = defines.back() == '\n' ? defines : defines + "\n";
+    size_t versionLine = source.find("#version");
+    if (versionLine == std::string::npos)
+        return block + source;
+    size_t lineEnd = source.find('\n', versionLine);
+    if (lineEnd == std::string::npos)
+        return source + "\n" + block;
+    std::string result = source;
+    result.insert(lineEnd + 1, block);
+    return result;
+}
 
-    // Ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+std::string ReadSource(const char* path) {
+    std::ifstream file;
+    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     try {
-        // Open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-
-        // Read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-
-        // Close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-
-        // Convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        file.open(path);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        return stream.str();
     }
     catch (std::ifstream::failure& e) {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << ": " << e.what() << std::endl;
+        return std::string();
+    }
+}
+
+const char* StageName(GLenum type) {
+    switch (type) {
+    case GL_VERTEX_SHADER: return "VERTEX";
+    case GL_FRAGMENT_SHADER: return "FRAGMENT";
+    default: return "COMPUTE";
+    }
+}
+
+// Lets the driver compile and link on as many threads as it likes
+void EnableParallelCompile() {
+    static bool enabled = false;
+    if (!enabled && GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
     }
+    enabled = true;
+}
+
+} // namespace
 
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines) {
+    std::vector<Stage> stages = {
+        { GL_VERTEX_SHADER, vertexPath, InsertDefines(ReadSource(vertexPath), defines) },
+        { GL_FRAGMENT_SHADER, fragmentPath, InsertDefines(ReadSource(fragmentPath), defines) }
+    };
+    build(stages);
+}
+
+Shader::Shader(const char* computePath, const std::string& defines) {
+    std::vector<Stage> stages = {
+        { GL_COMPUTE_SHADER, computePath, InsertDefines(ReadSource(computePath), defines) }
+    };
+    build(stages);
+}
 
-    // Compile shaders
-    GLuint vertex, fragment;
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX", vertexPath);
+void Shader::build(const std::vector<Stage>& stages) {
+    EnableParallelCompile();
 
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT", fragmentPath);
+    std::vector<std::string> sources;
+    for (const Stage& stage : stages) {
+        sources.push_back(stage.source);
+    }
+    cacheKey = ShaderCache::Key(sources);
 
-    // Shader program
     ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
+    if (ShaderCache::Load(ID, cacheKey)) {
+        linkFinished = true;
+        reflectUniforms();
+        return;
+    }
+
+    // Cold path: queue the compiles and the link without asking for their status, which would wait
+    linkFinished = false;
+    glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    for (const Stage& stage : stages) {
+        const char* code = stage.source.c_str();
+        GLuint shader = glCreateShader(stage.type);
+        glShaderSource(shader, 1, &code, NULL);
+        glCompileShader(shader);
+        glAttachShader(ID, shader);
+        pendingStages.push_back({ shader, StageName(stage.type), stage.path });
+    }
     glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM", "Shader Program");
+}
+
+void Shader::finishLink() const {
+    if (linkFinished)
+        return;
+    linkFinished = true;
 
-    // Delete the shaders as they're linked into our program now and no longer needed
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    for (const PendingStage& stage : pendingStages) {
+        checkCompileErrors(stage.shader, stage.type, stage.filename);
+        // The shaders are linked into the program now and no longer needed
+        glDetachShader(ID, stage.shader);
+        glDeleteShader(stage.shader);
+    }
+    pendingStages.clear();
+
+    if (checkCompileErrors(ID, "PROGRAM", "Shader Program")) {
+        ShaderCache::Store(ID, cacheKey);
+    }
+    reflectUniforms();
+}
+
+bool Shader::isReady() const {
+    if (linkFinished)
+        return true;
+    if (!GLEW_KHR_parallel_shader_compile)
+        return true; // The driver compiles synchronously, so collecting the status will not wait long
+    GLint complete = GL_FALSE;
+    glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
 }
 
 void Shader::use() {
+    finishLink();
     glUseProgram(ID);
 }
 
 void Shader::setBool(const std::string& name, bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform1i(getUniformLocation(name), (int)value);
 }
 
 void Shader::setInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(getUniformLocation(name), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(getUniformLocation(name), value);
 }
 
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+    glUniform3fv(getUniformLocation(name), 1, glm::value_ptr(value));
+}
+
+GLint Shader::getUniformLocation(const std::string& name) const {
+    finishLink();
+    auto it = uniformLocations.find(name);
+    return it != uniformLocations.end() ? it->second : -1;
+}
+
+void Shader::set(Uniform<bool> uniform, bool value) const {
+    glUniform1i(uniform.location, (int)value);
+}
+
+void Shader::set(Uniform<int> uniform, int value) const {
+    glUniform1i(uniform.location, value);
+}
+
+void Shader::set(Uniform<unsigned int> uniform, unsigned int value) const {
+    glUniform1ui(uniform.location, value);
+}
+
+void Shader::set(Uniform<float> uniform, float value) const {
+    glUniform1f(uniform.location, value);
+}
+
+void Shader::set(Uniform<glm::mat4> uniform, const glm::mat4& mat) const {
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::set(Uniform<glm::vec3> uniform, const glm::vec3& value) const {
+    glUniform3fv(uniform.location, 1, glm::value_ptr(value));
+}
+
+void Shader::set(Uniform<glm::vec2> uniform, const glm::vec2& value) const {
+    glUniform2fv(uniform.location, 1, glm::value_ptr(value));
+}
+
+void Shader::set(Uniform<glm::ivec2> uniform, const glm::ivec2& value) const {
+    glUniform2i(uniform.location, value.x, value.y);
+}
+
+void Shader::set(Uniform<glm::uvec3> uniform, const glm::uvec3& value) const {
+    glUniform3ui(uniform.location, value.x, value.y, value.z);
+}
+
+void Shader::reflectUniforms() const {
+    uniformLocations.clear();
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
+
+        // Block members have no location of their own
+        GLint location = glGetUniformLocation(ID, name.c_str());
+        if (location < 0)
+            continue;
+        uniformLocations[name] = location;
+
+        // Arrays of basic types are reported once as "name[0]"; register the bare name and every element
+        if (size > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+            std::string base = name.substr(0, name.size() - 3);
+            uniformLocations[base] = location;
+            for (GLint element = 1; element < size; ++element) {
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                uniformLocations[elementName] = glGetUniformLocation(ID, elementName.c_str());
+            }
+        }
+    }
 }
 
-void Shader::checkCompileErrors(GLuint shader, const std::string& type, const std::string& filename) {
+bool Shader::checkCompileErrors(GLuint shader, const std::string& type, const std::string& filename) {
     GLint success;
     GLchar infoLog[1024];
     if (type != "PROGRAM") {
@@ -103,4 +248,5 @@ void Shader::checkCompileErrors(GLuint shader, const std::string& type, const st
                 << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
         }
     }
+    return success == GL_TRUE;
 }
@@ -3,26 +3,84 @@
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 
+// Typed handle to a uniform location, resolved once so per-frame code never touches names
+template <typename T>
+struct Uniform {
+    GLint location = -1;
+};
+
+// A linked program. Construction only issues the work: the binary comes from ShaderCache when it
+// has one, otherwise compiling and linking run on the driver's threads (KHR_parallel_shader_compile)
+// while the caller creates more shaders. Link status is collected on first use or uniform lookup.
 class Shader {
 public:
     GLuint ID;
 
-    Shader(const char* vertexPath, const char* fragmentPath);
+    // defines ("#define NAME VALUE" lines) are inserted after each stage's #version line
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines = "");
+    explicit Shader(const char* computePath, const std::string& defines = "");
     void use();
 
+    // False while the driver is still compiling or linking; never blocks
+    bool isReady() const;
+
     void setBool(const std::string& name, bool value) const;
     void setInt(const std::string& name, int value) const;
     void setFloat(const std::string& name, float value) const;
     void setMat4(const std::string& name, const glm::mat4& mat) const;
     void setVec3(const std::string& name, const glm::vec3& value) const;
 
+    // Location from the table reflected at link time (-1 if the uniform is not active)
+    GLint getUniformLocation(const std::string& name) const;
+
+    template <typename T>
+    Uniform<T> getUniform(const std::string& name) const {
+        Uniform<T> uniform;
+        uniform.location = getUniformLocation(name);
+        return uniform;
+    }
+
+    void set(Uniform<bool> uniform, bool value) const;
+    void set(Uniform<int> uniform, int value) const;
+    void set(Uniform<unsigned int> uniform, unsigned int value) const;
+    void set(Uniform<float> uniform, float value) const;
+    void set(Uniform<glm::mat4> uniform, const glm::mat4& mat) const;
+    void set(Uniform<glm::vec3> uniform, const glm::vec3& value) const;
+    void set(Uniform<glm::vec2> uniform, const glm::vec2& value) const;
+    void set(Uniform<glm::ivec2> uniform, const glm::ivec2& value) const;
+    void set(Uniform<glm::uvec3> uniform, const glm::uvec3& value) const;
+
 private:
-    void checkCompileErrors(GLuint shader, const std::string& type, const std::string& filename);
+    struct Stage {
+        GLenum type;
+        const char* path;
+        std::string source;
+    };
+    // Stages of a cold compile, checked and released once the link is collected
+    struct PendingStage {
+        GLuint shader;
+        std::string type;
+        std::string filename;
+    };
+
+    uint64_t cacheKey;
+    // Filled in by finishLink, which const lookups may trigger
+    mutable bool linkFinished;
+    mutable std::vector<PendingStage> pendingStages;
+    mutable std::unordered_map<std::string, GLint> uniformLocations;
+
+    void build(const std::vector<Stage>& stages);
+    void finishLink() const;
+    static bool checkCompileErrors(GLuint shader, const std::string& type, const std::string& filename);
+    void reflectUniforms() const;
 };
 
 #endif // SHADER_H
@@ -0,0 +1,129 @@
+#include "ShaderCache.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+const uint32_t kMagic = 0x47525053; // "SPRG"
+const uint32_t kVersion = 1;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;      // Guards against a renamed or truncated file
+    uint32_t format;   // Driver-specific binary format from glGetProgramBinary
+    uint32_t length;
+};
+
+// 64-bit FNV-1a
+uint64_t Hash(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t HashString(uint64_t hash, const char* text) {
+    // The terminator keeps ("ab", "c") and ("a", "bc") apart
+    return Hash(hash, text ? text : "", text ? std::strlen(text) + 1 : 1);
+}
+
+void MakeDirectory(const std::string& path) {
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+} // namespace
+
+std::string ShaderCache::directory = "ShaderCache";
+
+uint64_t ShaderCache::Key(const std::vector<std::string>& sources) {
+    uint64_t hash = 14695981039346656037ull;
+    hash = Hash(hash, &kVersion, sizeof(kVersion));
+    hash = HashString(hash, (const char*)glGetString(GL_VENDOR));
+    hash = HashString(hash, (const char*)glGetString(GL_RENDERER));
+    hash = HashString(hash, (const char*)glGetString(GL_VERSION));
+    for (const std::string& source : sources) {
+        hash = HashString(hash, source.c_str());
+    }
+    return hash;
+}
+
+bool ShaderCache::Load(GLuint program, uint64_t key) {
+    if (!IsSupported())
+        return false;
+
+    MappedFile file;
+    if (!file.Open(PathFor(key)) || file.GetSize() < sizeof(Header))
+        return false;
+
+    Header header;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion || header.key != key
+        || file.GetSize() - sizeof(Header) < header.length)
+        return false;
+
+    // The driver may still reject a binary it wrote itself, e.g. after a partial update
+    glProgramBinary(program, header.format, file.GetData() + sizeof(Header), (GLsizei)header.length);
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    return linked == GL_TRUE;
+}
+
+void ShaderCache::Store(GLuint program, uint64_t key) {
+    if (!IsSupported())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<unsigned char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    Header header = { kMagic, kVersion, key, format, (uint32_t)length };
+    MakeDirectory(directory);
+    std::ofstream file(PathFor(key), std::ios::binary);
+    if (!file) {
+        std::cerr << "Could not write shader cache entry " << PathFor(key) << std::endl;
+        return;
+    }
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)binary.data(), length);
+}
+
+void ShaderCache::SetDirectory(const std::string& path) {
+    directory = path;
+}
+
+bool ShaderCache::IsSupported() {
+    static int formatCount = -1;
+    if (formatCount < 0) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    }
+    return formatCount > 0;
+}
+
+std::string ShaderCache::PathFor(uint64_t key) {
+    static const char* kDigits = "0123456789abcdef";
+    std::string name(16, '0');
+    for (int i = 15; i >= 0; --i, key >>= 4) {
+        name[i] = kDigits[key & 0xF];
+    }
+    return directory + "/" + name + ".bin";
+}
@@ -0,0 +1,32 @@
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// On-disk cache of linked program binaries (glGetProgramBinary). Entries are keyed by a hash of every
+// stage's final source, defines included, and of the driver's vendor, renderer and version strings,
+// so an edited shader or a driver update just misses and the program is compiled again.
+class ShaderCache {
+public:
+    static uint64_t Key(const std::vector<std::string>& sources);
+
+    // True if program now holds a successfully linked binary for key
+    static bool Load(GLuint program, uint64_t key);
+    // Saves a linked program under key. It must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    static void Store(GLuint program, uint64_t key);
+
+    // Directory the binaries live in, "ShaderCache" by default; created on the first store
+    static void SetDirectory(const std::string& path);
+    // False when the driver offers no binary formats; Load and Store then do nothing
+    static bool IsSupported();
+
+private:
+    static std::string directory;
+
+    static std::string PathFor(uint64_t key);
+};
+
+#endif // SHADERCACHE_H
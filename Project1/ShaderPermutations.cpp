@@ -0,0 +1,29 @@
+#include "ShaderPermutations.h"
+
+ShaderDefines& ShaderDefines::Set(const char* name, int value) {
+    text += "#define ";
+    text += name;
+    text += " ";
+    text += std::to_string(value);
+    text += "\n";
+    return *this;
+}
+
+ShaderPermutations::ShaderPermutations(const char* vertexPath, const char* fragmentPath)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath) {
+}
+
+ShaderPermutations::~ShaderPermutations() {
+    for (auto& variant : variants) {
+        glDeleteProgram(variant.second.ID);
+    }
+}
+
+Shader& ShaderPermutations::Get(const ShaderDefines& defines) {
+    auto it = variants.find(defines.GetText());
+    if (it == variants.end()) {
+        // Node-based map: references handed out stay valid as variants are added
+        it = variants.emplace(defines.GetText(), Shader(vertexPath.c_str(), fragmentPath.c_str(), defines.GetText())).first;
+    }
+    return it->second;
+}
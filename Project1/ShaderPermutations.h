@@ -0,0 +1,41 @@
+#ifndef SHADERPERMUTATIONS_H
+#define SHADERPERMUTATIONS_H
+
+#include <string>
+#include <unordered_map>
+#include "Shader.h"
+
+// Builds the "#define NAME VALUE" block a permutation is keyed by. Defines are emitted in the order
+// they are set, so callers set them in a fixed order to get the same key for the same features.
+class ShaderDefines {
+public:
+    ShaderDefines& Set(const char* name, int value);
+    ShaderDefines& Set(const char* name, bool value) { return Set(name, value ? 1 : 0); }
+    const std::string& GetText() const { return text; }
+
+private:
+    std::string text;
+};
+
+// Every variant of one vertex/fragment pair. The shaders guard each feature with #if, so a variant
+// only carries the code its features need. Each define set is compiled once, on first request,
+// and kept until the family is destroyed.
+class ShaderPermutations {
+public:
+    ShaderPermutations(const char* vertexPath, const char* fragmentPath);
+    ~ShaderPermutations();
+
+    ShaderPermutations(const ShaderPermutations&) = delete;
+    ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+    // The program for this define set, building it on first request
+    Shader& Get(const ShaderDefines& defines);
+    size_t GetVariantCount() const { return variants.size(); }
+
+private:
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::unordered_map<std::string, Shader> variants; // Keyed by the define block
+};
+
+#endif // SHADERPERMUTATIONS_H
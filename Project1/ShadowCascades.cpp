@@ -0,0 +1,88 @@
+#include "ShadowCascades.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+
+glm::mat4 ShadowCascade::GetProjection(float nearDistance) const {
+    return glm::ortho(center.x - radius, center.x + radius, center.y - radius, center.y + radius, nearDistance, GetFarDistance());
+}
+
+bool ShadowCascade::Contains(const ShadowCascade& other) const {
+    return glm::length(other.center - center) + other.radius <= radius;
+}
+
+void ShadowCascade::SnapToTexels(int resolution) {
+    float texelSize = 2.0f * radius / (float)resolution;
+    center.x = std::floor(center.x / texelSize) * texelSize;
+    center.y = std::floor(center.y / texelSize) * texelSize;
+}
+
+ShadowCascade ShadowCascade::Padded(float padding, int resolution) const {
+    ShadowCascade padded = *this;
+    padded.radius = std::ceil(radius * (1.0f + padding) * 16.0f) / 16.0f;
+    padded.SnapToTexels(resolution);
+    return padded;
+}
+
+glm::mat4 ShadowLightView(const glm::vec3& lightDirection) {
+    glm::vec3 direction = glm::normalize(lightDirection);
+    // lookAt degenerates when looking straight along the up vector
+    glm::vec3 up = std::fabs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    return glm::lookAt(glm::vec3(0.0f), direction, up);
+}
+
+void ComputeCascadeSplits(float nearPlane, float farPlane, float lambda, float* splits, int cascadeCount) {
+    for (int i = 0; i < cascadeCount; ++i) {
+        float fraction = (float)(i + 1) / (float)cascadeCount;
+        float logarithmic = nearPlane * std::pow(farPlane / nearPlane, fraction);
+        float uniform = nearPlane + (farPlane - nearPlane) * fraction;
+        splits[i] = lambda * logarithmic + (1.0f - lambda) * uniform;
+    }
+}
+
+void FitShadowCascades(const glm::mat4& inverseViewProjection, float nearPlane, float farPlane, const float* splits,
+    const glm::mat4& lightView, int resolution, ShadowCascade* cascades, int cascadeCount) {
+    // World-space corners of the whole frustum; slices interpolate along its four edges, which is
+    // linear in view depth
+    glm::vec3 nearCorners[4];
+    glm::vec3 farCorners[4];
+    for (int i = 0; i < 4; ++i) {
+        float x = (i & 1) ? 1.0f : -1.0f;
+        float y = (i & 2) ? 1.0f : -1.0f;
+        glm::vec4 nearCorner = inverseViewProjection * glm::vec4(x, y, -1.0f, 1.0f);
+        glm::vec4 farCorner = inverseViewProjection * glm::vec4(x, y, 1.0f, 1.0f);
+        nearCorners[i] = glm::vec3(nearCorner) / nearCorner.w;
+        farCorners[i] = glm::vec3(farCorner) / farCorner.w;
+    }
+
+    float sliceNear = nearPlane;
+    for (int cascade = 0; cascade < cascadeCount; ++cascade) {
+        float sliceFar = splits[cascade];
+        float t0 = (sliceNear - nearPlane) / (farPlane - nearPlane);
+        float t1 = (sliceFar - nearPlane) / (farPlane - nearPlane);
+
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int i = 0; i < 4; ++i) {
+            glm::vec3 edge = farCorners[i] - nearCorners[i];
+            corners[i] = nearCorners[i] + edge * t0;
+            corners[i + 4] = nearCorners[i] + edge * t1;
+            center += corners[i] + corners[i + 4];
+        }
+        center /= 8.0f;
+
+        float radius = 0.0f;
+        for (const glm::vec3& corner : corners) {
+            radius = std::max(radius, glm::length(corner - center));
+        }
+        // Round up so float noise in the corners cannot change the texel size frame to frame
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        cascades[cascade].splitNear = sliceNear;
+        cascades[cascade].splitFar = sliceFar;
+        cascades[cascade].center = glm::vec3(lightView * glm::vec4(center, 1.0f));
+        cascades[cascade].radius = radius;
+        cascades[cascade].SnapToTexels(resolution);
+        sliceNear = sliceFar;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef SHADOWCASCADES_H
+#define SHADOWCASCADES_H
+
+#include <glm/glm.hpp>
+
+// One cascade of a directional shadow map: the bounding sphere of a slice of the camera
+// frustum, in light view space. A sphere keeps the ortho extent constant while the camera
+// turns, and snapping its centre to whole texels keeps shadow edges from shimmering as it moves.
+struct ShadowCascade {
+    float splitNear;   // Camera view depth the slice starts at
+    float splitFar;    // ... and ends at; the lighting pass hands over to the next cascade here
+    glm::vec3 center;  // Light view space
+    float radius;
+
+    // Light-view distance to the front and back of the sphere
+    float GetNearDistance() const { return -center.z - radius; }
+    float GetFarDistance() const { return -center.z + radius; }
+
+    // Ortho projection around the sphere; nearDistance may be pulled towards the light to take
+    // in casters in front of the slice
+    glm::mat4 GetProjection(float nearDistance) const;
+
+    // True if other's sphere lies entirely inside this one
+    bool Contains(const ShadowCascade& other) const;
+    // Moves the centre onto the texel grid of a map of the given resolution
+    void SnapToTexels(int resolution);
+    // Copy grown by padding (a fraction of the radius) and re-snapped, so the slice can drift
+    // that far before the cascade has to move
+    ShadowCascade Padded(float padding, int resolution) const;
+};
+
+// Rotation-only view looking down the light direction; every cascade shares it so snapping
+// is done in one fixed texel grid orientation
+glm::mat4 ShadowLightView(const glm::vec3& lightDirection);
+
+// Splits [nearPlane, farPlane] with the practical split scheme: lambda blends the logarithmic
+// split (1, even texel density in perspective) with the uniform one (0)
+void ComputeCascadeSplits(float nearPlane, float farPlane, float lambda, float* splits, int cascadeCount);
+
+// Fits cascade i to the camera frustum between splits[i - 1] (nearPlane for i = 0) and splits[i].
+// inverseViewProjection is the camera's; resolution is the shadow map size in texels.
+void FitShadowCascades(const glm::mat4& inverseViewProjection, float nearPlane, float farPlane, const float* splits,
+    const glm::mat4& lightView, int resolution, ShadowCascade* cascades, int cascadeCount);
+
+#endif // SHADOWCASCADES_H
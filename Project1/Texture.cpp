@@ -1,14 +1,57 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-#include "texture.h"
+#include "Texture.h"
 
 // Constructor for Texture
 Texture::Texture(const std::string& path, const std::string& type)
-    : path(path), type(type) {
+    : path(path), type(type), resource(std::make_shared<TextureResource>()) {
+    id = resource->id;
     loadTexture(path);
 }
 
+Texture::Texture(const std::string& path, const std::string& type, TextureLoader& loader, TextureLoader::Callback onLoaded)
+    : path(path), type(type), resource(std::make_shared<TextureResource>()) {
+    id = resource->id;
+    // The pending load holds a reference so the GL name cannot be deleted (and reused) mid-upload
+    std::shared_ptr<TextureResource> owner = resource;
+    loader.Load(id, path, [owner, onLoaded](GLuint texture, bool loaded) {
+        if (loaded)
+            owner->residentBytes = TextureResource::QueryResidentBytes(texture);
+        if (onLoaded)
+            onLoaded(texture, loaded);
+    });
+}
+
+Texture::Texture(const std::shared_ptr<TextureResource>& resource, const std::string& path, const std::string& type)
+    : path(path), type(type), resource(resource) {
+    id = resource->id;
+}
+
+size_t TextureResource::QueryResidentBytes(GLuint texture) {
+    GLint width = 0, height = 0, compressed = 0;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+
+    size_t levelBytes = 0;
+    if (compressed) {
+        GLint imageSize = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &imageSize);
+        levelBytes = (size_t)imageSize;
+    }
+    else {
+        GLint bits[4] = {};
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_RED_SIZE, &bits[0]);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_GREEN_SIZE, &bits[1]);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_BLUE_SIZE, &bits[2]);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_ALPHA_SIZE, &bits[3]);
+        levelBytes = (size_t)width * height * (bits[0] + bits[1] + bits[2] + bits[3]) / 8;
+    }
+    return levelBytes + levelBytes / 3;
+}
+
 // Bind the texture to a texture unit
 void Texture::bind(unsigned int unit) const {
     glActiveTexture(GL_TEXTURE0 + unit);
@@ -17,7 +60,6 @@ void Texture::bind(unsigned int unit) const {
 
 // Load the texture using STB image
 void Texture::loadTexture(const std::string& path) {
-    glGenTextures(1, &id);
     glBindTexture(GL_TEXTURE_2D, id);
 
     int width, height, nrChannels;
@@ -40,6 +82,7 @@ void Texture::loadTexture(const std::string& path) {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
         stbi_image_free(data);
+        resource->residentBytes = TextureResource::QueryResidentBytes(id);
     }
     else {
         std::cerr << "Failed to load texture at path: " << path << std::endl;
@@ -2,9 +2,26 @@
 #define TEXTURE_H
 
 #include <GL/glew.h>  // Use GLEW instead of GLAD
+#include <memory>
 #include <string>
 #include <iostream>
+#include "TextureLoader.h"
 
+// Owns one GL texture object; deleted when the last Texture sharing it goes away
+struct TextureResource {
+    GLuint id = 0;
+    size_t residentBytes = 0; // Estimated VRAM including mips, known once the upload completes
+
+    TextureResource() { glGenTextures(1, &id); }
+    ~TextureResource() { glDeleteTextures(1, &id); }
+    TextureResource(const TextureResource&) = delete;
+    TextureResource& operator=(const TextureResource&) = delete;
+
+    // Sizes level 0 from GL and adds a third for the mip chain
+    static size_t QueryResidentBytes(GLuint texture);
+};
+
+// Copyable handle to a shared TextureResource
 class Texture {
 public:
     unsigned int id;
@@ -12,10 +29,18 @@ public:
     std::string path;
 
     Texture(const std::string& path, const std::string& type);
+    // Returns immediately with a placeholder; loader decodes and uploads the image in the background
+    Texture(const std::string& path, const std::string& type, TextureLoader& loader, TextureLoader::Callback onLoaded = nullptr);
+
+    // Wraps a resource owned by TextureManager
+    Texture(const std::shared_ptr<TextureResource>& resource, const std::string& path, const std::string& type);
 
     void bind(unsigned int unit) const;
+    const std::shared_ptr<TextureResource>& getResource() const { return resource; }
 
 private:
+    std::shared_ptr<TextureResource> resource;
+
     void loadTexture(const std::string& path);
 };
 
@@ -0,0 +1,358 @@
+#include "TextureLoader.h"
+#include <stb_image.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const unsigned char kPlaceholderColor[4] = { 128, 128, 128, 255 };
+
+void ImageFormats(int channels, GLenum& format, GLenum& internalFormat) {
+    switch (channels) {
+    case 1: format = GL_RED; internalFormat = GL_R8; break;
+    case 2: format = GL_RG; internalFormat = GL_RG8; break;
+    case 3: format = GL_RGB; internalFormat = GL_RGB8; break;
+    default: format = GL_RGBA; internalFormat = GL_RGBA8; break;
+    }
+}
+
+// 0 for formats we cannot upload: S3TC (BC1/BC3) is an extension, not core GL
+GLenum CompressedFormat(DDSFormat format) {
+    switch (format) {
+    case DDSFormat::BC1: return GLEW_EXT_texture_compression_s3tc ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+    case DDSFormat::BC3: return GLEW_EXT_texture_compression_s3tc ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+    case DDSFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+    case DDSFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+    case DDSFormat::BC7: return GLEW_ARB_texture_compression_bptc ? GL_COMPRESSED_RGBA_BPTC_UNORM : 0;
+    default: return 0;
+    }
+}
+
+bool IsDDSPath(const std::string& path) {
+    if (path.size() < 4)
+        return false;
+    std::string extension = path.substr(path.size() - 4);
+    for (auto& c : extension) {
+        c = (char)std::tolower((unsigned char)c);
+    }
+    return extension == ".dds";
+}
+
+int MipLevelCount(int width, int height) {
+    int levels = 1;
+    while ((width | height) >> levels) {
+        ++levels;
+    }
+    return levels;
+}
+
+} // namespace
+
+TextureLoader::TextureLoader(size_t uploadBudgetBytes)
+    : uploadBudget(uploadBudgetBytes), ringIndex(0), stopping(false), outstanding(0) {
+    // Persistent + coherent: the CPU writes straight into memory the GL can source uploads from
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    for (auto& slot : ring) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, uploadBudget, nullptr, flags);
+        slot.mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, uploadBudget, flags);
+        slot.fence = nullptr;
+        slot.fenceFlushed = false;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    unsigned int workerCount = std::max(1u, std::min(4u, hardwareThreads > 1 ? hardwareThreads - 1 : 1u));
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&TextureLoader::WorkerLoop, this);
+    }
+}
+
+TextureLoader::~TextureLoader() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (auto& image : decoded) {
+        stbi_image_free(image.pixels);
+    }
+    for (auto& image : uploads) {
+        stbi_image_free(image.pixels);
+    }
+
+    for (auto& slot : ring) {
+        if (slot.fence)
+            glDeleteSync(slot.fence);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glDeleteBuffers(1, &slot.buffer);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void TextureLoader::Load(GLuint texture, const std::string& path, Callback callback) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, kPlaceholderColor);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    ++outstanding;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back({ texture, path, callback });
+    }
+    jobReady.notify_one();
+}
+
+void TextureLoader::WorkerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        DecodedImage image;
+        image.texture = job.texture;
+        image.path = std::move(job.path);
+        image.callback = std::move(job.callback);
+        image.pixels = nullptr;
+        image.nextRow = 0;
+        image.compressed = IsDDSPath(image.path);
+        image.nextLevel = 0;
+        image.started = false;
+        if (image.compressed) {
+            // Cooked files are already in GPU format; reading them is the whole "decode"
+            bool read = ReadDDS(image.path, image.dds);
+            if (read && CompressedFormat(image.dds.format) != 0) {
+                image.width = (int)image.dds.levels[0].width;
+                image.height = (int)image.dds.levels[0].height;
+                image.nextLevel = (int)image.dds.levels.size() - 1;
+            }
+            else {
+                if (read)
+                    std::cerr << "Texture compression format not supported by the driver: " << image.path << std::endl;
+                image.dds.levels.clear();
+            }
+        }
+        else {
+            image.pixels = stbi_load(image.path.c_str(), &image.width, &image.height, &image.channels, 0);
+        }
+
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        decoded.push_back(std::move(image));
+    }
+}
+
+void TextureLoader::BeginUpload(DecodedImage& image) {
+    GLenum format, internalFormat;
+    ImageFormats(image.channels, format, internalFormat);
+
+    // Allocate the whole chain and put the placeholder in the last level, which is all that
+    // gets sampled until level 0 is complete. A bound unpack buffer would turn the null storage
+    // pointers and the placeholder into PBO offsets
+    int levels = MipLevelCount(image.width, image.height);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, image.texture);
+    for (int level = 0; level < levels; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, internalFormat, std::max(1, image.width >> level), std::max(1, image.height >> level),
+            0, format, GL_UNSIGNED_BYTE, nullptr);
+    }
+    std::vector<unsigned char> placeholder(image.channels);
+    std::memcpy(placeholder.data(), kPlaceholderColor, image.channels);
+    glTexSubImage2D(GL_TEXTURE_2D, levels - 1, 0, 0, 1, 1, format, GL_UNSIGNED_BYTE, placeholder.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
+
+void TextureLoader::BeginCompressedUpload(DecodedImage& image) {
+    GLenum format = CompressedFormat(image.dds.format);
+    // A bound unpack buffer would turn the null storage pointer into a PBO offset
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, image.texture);
+    for (size_t level = 0; level < image.dds.levels.size(); ++level) {
+        const DDSLevel& mip = image.dds.levels[level];
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, format, mip.width, mip.height, 0, (GLsizei)mip.size, nullptr);
+    }
+    int lastLevel = (int)image.dds.levels.size() - 1;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, lastLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lastLevel);
+}
+
+bool TextureLoader::UploadCompressedLevels(DecodedImage& image, RingSlot& slot, size_t& used) {
+    GLenum format = CompressedFormat(image.dds.format);
+    glBindTexture(GL_TEXTURE_2D, image.texture);
+    while (image.nextLevel >= 0) {
+        const DDSLevel& mip = image.dds.levels[image.nextLevel];
+        const unsigned char* source = image.dds.data.data() + mip.offset;
+        if (used + mip.size <= uploadBudget) {
+            std::memcpy(slot.mapped + used, source, mip.size);
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, image.nextLevel, 0, 0, mip.width, mip.height, format, (GLsizei)mip.size, (void*)used);
+            used += mip.size;
+        }
+        else if (used == 0) {
+            // A level larger than the whole budget goes straight from client memory
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, image.nextLevel, 0, 0, mip.width, mip.height, format, (GLsizei)mip.size, source);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            used = uploadBudget;
+        }
+        else {
+            return false;
+        }
+
+        // The finished level and everything below it can be sampled now
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, image.nextLevel);
+        --image.nextLevel;
+    }
+    return true;
+}
+
+void TextureLoader::FinishUpload(DecodedImage& image, bool loaded) {
+    if (loaded && image.compressed) {
+        glBindTexture(GL_TEXTURE_2D, image.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    }
+    else if (loaded) {
+        glBindTexture(GL_TEXTURE_2D, image.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    else {
+        std::cerr << "Failed to load texture at path: " << image.path << std::endl;
+    }
+
+    stbi_image_free(image.pixels);
+    image.pixels = nullptr;
+    --outstanding;
+    if (image.callback)
+        image.callback(image.texture, loaded);
+}
+
+void TextureLoader::Update() {
+    {
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        while (!decoded.empty()) {
+            uploads.push_back(std::move(decoded.front()));
+            decoded.pop_front();
+        }
+    }
+    if (uploads.empty())
+        return;
+
+    // The slot was last used kRingSize updates ago; its copies are almost certainly done. Poll
+    // rather than wait so a busy GPU delays uploads, not the frame.
+    RingSlot& slot = ring[ringIndex];
+    if (slot.fence) {
+        GLenum status = glClientWaitSync(slot.fence, slot.fenceFlushed ? 0 : GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        slot.fenceFlushed = true;
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            return; // The GPU may still be reading the buffer; uploads stay queued for the same slot
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+    ringIndex = (ringIndex + 1) % kRingSize;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+
+    size_t used = 0;
+    while (!uploads.empty()) {
+        DecodedImage& image = uploads.front();
+        if (image.compressed && !image.dds.levels.empty()) {
+            if (!image.started) {
+                BeginCompressedUpload(image);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+                image.started = true;
+            }
+            if (!UploadCompressedLevels(image, slot, used))
+                break; // Budget spent; continue next frame
+
+            DecodedImage done = std::move(image);
+            uploads.pop_front();
+            FinishUpload(done, true);
+            continue;
+        }
+        if (!image.pixels) {
+            DecodedImage failed = std::move(image);
+            uploads.pop_front();
+            FinishUpload(failed, false);
+            continue;
+        }
+        if (!image.started) {
+            BeginUpload(image);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            image.started = true;
+        }
+
+        GLenum format, internalFormat;
+        ImageFormats(image.channels, format, internalFormat);
+        size_t rowBytes = (size_t)image.width * image.channels;
+        int rows = std::min(image.height - image.nextRow, (int)((uploadBudget - used) / rowBytes));
+        glBindTexture(GL_TEXTURE_2D, image.texture);
+        if (rows == 0) {
+            if (used > 0)
+                break; // Budget spent; continue next frame
+
+            // A single row larger than the whole budget: upload it straight from client memory
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, image.nextRow, image.width, 1, format, GL_UNSIGNED_BYTE,
+                image.pixels + image.nextRow * rowBytes);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            rows = 1;
+            used = uploadBudget;
+        }
+        else {
+            std::memcpy(slot.mapped + used, image.pixels + image.nextRow * rowBytes, rows * rowBytes);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, image.nextRow, image.width, rows, format, GL_UNSIGNED_BYTE, (void*)used);
+            used += rows * rowBytes;
+        }
+
+        image.nextRow += rows;
+        if (image.nextRow < image.height)
+            break;
+
+        DecodedImage done = std::move(image);
+        uploads.pop_front();
+        FinishUpload(done, true);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.fenceFlushed = false;
+}
+
+void TextureLoader::Finish() {
+    while (outstanding.load() > 0) {
+        bool idle;
+        {
+            std::lock_guard<std::mutex> lock(decodedMutex);
+            idle = decoded.empty() && uploads.empty();
+        }
+        if (idle) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        Update();
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <GL/glew.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DDS.h"
+
+// Decodes images on worker threads and streams them into GL textures from the GL thread.
+// Uploads go through a ring of persistently mapped pixel unpack buffers, limited to a byte
+// budget per Update() so a large texture is spread over several frames instead of stalling one.
+//
+// While a texture loads, its GL object holds a full mip chain whose smallest level is a grey
+// placeholder; BASE_LEVEL points at that level so sampling never sees partially written rows.
+//
+// Cooked .dds files (see TextureCooker) skip decoding entirely: their precomputed block-compressed
+// mips are uploaded smallest first, and BASE_LEVEL follows each finished level down to 0.
+class TextureLoader {
+public:
+    // Called on the GL thread once the texture is complete (or failed to decode)
+    using Callback = std::function<void(GLuint texture, bool loaded)>;
+
+    static const size_t kDefaultUploadBudget = 8 * 1024 * 1024;
+
+    explicit TextureLoader(size_t uploadBudgetBytes = kDefaultUploadBudget);
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // Gives texture a 1x1 placeholder now and queues path for decoding
+    void Load(GLuint texture, const std::string& path, Callback callback = nullptr);
+
+    // Uploads up to the byte budget of decoded data and fires callbacks; call once per frame
+    void Update();
+    // Blocks until every queued texture has been uploaded (benchmarks and loading screens)
+    void Finish();
+
+    size_t GetPendingCount() const { return outstanding.load(); }
+
+private:
+    struct Job {
+        GLuint texture;
+        std::string path;
+        Callback callback;
+    };
+
+    struct DecodedImage {
+        GLuint texture;
+        std::string path;
+        Callback callback;
+        unsigned char* pixels; // stbi-owned
+        int width;
+        int height;
+        int channels;
+        int nextRow;           // First row of level 0 not uploaded yet
+        DDSImage dds;          // Used instead of pixels for compressed files
+        bool compressed;
+        int nextLevel;         // Next compressed level to upload, counting down to 0
+        bool started;          // Storage allocated by BeginUpload / BeginCompressedUpload
+    };
+
+    static const int kRingSize = 3;
+
+    struct RingSlot {
+        GLuint buffer;
+        unsigned char* mapped;
+        GLsync fence;
+        bool fenceFlushed; // The first poll flushed the commands the fence waits on
+    };
+
+    size_t uploadBudget;
+    RingSlot ring[kRingSize];
+    int ringIndex;
+
+    std::vector<std::thread> workers;
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::deque<Job> jobs;
+    bool stopping;
+
+    std::mutex decodedMutex;
+    std::deque<DecodedImage> decoded;
+
+    std::deque<DecodedImage> uploads; // GL thread only
+    std::atomic<size_t> outstanding;
+
+    void WorkerLoop();
+    void BeginUpload(DecodedImage& image);
+    void BeginCompressedUpload(DecodedImage& image);
+    // Uploads as many whole levels as fit; returns false once the budget is spent
+    bool UploadCompressedLevels(DecodedImage& image, RingSlot& slot, size_t& used);
+    void FinishUpload(DecodedImage& image, bool loaded);
+};
+
+#endif // TEXTURELOADER_H
@@ -0,0 +1,83 @@
+#include "TextureManager.h"
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+// Offline-cooked block-compressed version of a source image, if TextureCooker has produced one
+std::string CookedPath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return path + ".dds";
+    return path.substr(0, dot) + ".dds";
+}
+
+} // namespace
+
+TextureManager::TextureManager(TextureLoader& loader, size_t budgetBytes)
+    // Cooked colour maps are BC1/BC3, which are S3TC: an extension rather than core GL
+    : loader(loader), budget(budgetBytes), useCooked(GLEW_EXT_texture_compression_s3tc != 0) {
+    if (!useCooked) {
+        std::cerr << "S3TC texture compression not supported; loading source images instead of cooked textures" << std::endl;
+    }
+}
+
+std::string TextureManager::MakeKey(const std::string& path, const TextureSettings& settings) {
+    return path + "|" + std::to_string(settings.wrap) + "|" + std::to_string(settings.minFilter) + "|" + std::to_string(settings.magFilter);
+}
+
+Texture TextureManager::Acquire(const std::string& path, const std::string& type, const TextureSettings& settings) {
+    std::string key = MakeKey(path, settings);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        lru.splice(lru.begin(), lru, it->second.lruPosition);
+        return Texture(it->second.resource, path, type);
+    }
+
+    // Prefer the cooked DDS next to the source: no decode and precomputed compressed mips
+    std::string loadPath = path;
+    std::string cooked = CookedPath(path);
+    if (useCooked && cooked != path && std::ifstream(cooked, std::ios::binary).good()) {
+        loadPath = cooked;
+    }
+
+    Texture texture(loadPath, type, loader);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, settings.wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, settings.wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, settings.minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, settings.magFilter);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    lru.push_front(key);
+    entries[key] = { texture.getResource(), lru.begin() };
+    return texture;
+}
+
+size_t TextureManager::GetResidentBytes() const {
+    size_t total = 0;
+    for (const auto& entry : entries) {
+        total += entry.second.resource->residentBytes;
+    }
+    return total;
+}
+
+void TextureManager::Update() {
+    size_t resident = GetResidentBytes();
+    if (resident <= budget)
+        return;
+
+    // Walk from the least recently acquired end; the cache's own reference is the only one left
+    // when use_count is 1
+    for (auto it = lru.end(); it != lru.begin() && resident > budget;) {
+        --it;
+        auto entry = entries.find(*it);
+        if (entry->second.resource.use_count() > 1)
+            continue;
+
+        resident -= entry->second.resource->residentBytes;
+        entries.erase(entry);
+        it = lru.erase(it);
+    }
+}
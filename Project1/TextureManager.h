@@ -0,0 +1,53 @@
+#ifndef TEXTUREMANAGER_H
+#define TEXTUREMANAGER_H
+
+#include <GL/glew.h>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "Texture.h"
+#include "TextureLoader.h"
+
+// Sampler state baked into a cached texture; part of the cache key
+struct TextureSettings {
+    GLenum wrap = GL_REPEAT;
+    GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLenum magFilter = GL_LINEAR;
+};
+
+// Loads each (path, settings) pair once and hands out shared Texture handles to it.
+// The cache keeps its own reference so a texture survives being briefly unused; once the
+// resident total goes over budget, textures nobody else references are evicted oldest first.
+class TextureManager {
+public:
+    static const size_t kDefaultBudget = 512ull * 1024 * 1024;
+
+    explicit TextureManager(TextureLoader& loader, size_t budgetBytes = kDefaultBudget);
+
+    Texture Acquire(const std::string& path, const std::string& type, const TextureSettings& settings = TextureSettings());
+
+    // Evicts unreferenced least-recently-acquired textures until under budget; call once per frame
+    void Update();
+
+    void SetBudget(size_t bytes) { budget = bytes; }
+    size_t GetBudget() const { return budget; }
+    size_t GetResidentBytes() const;
+    size_t GetTextureCount() const { return entries.size(); }
+
+private:
+    struct Entry {
+        std::shared_ptr<TextureResource> resource;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    TextureLoader& loader;
+    size_t budget;
+    bool useCooked; // Off when the driver cannot upload the cooker's BC1/BC3 output
+    std::unordered_map<std::string, Entry> entries;
+    std::list<std::string> lru; // Most recently acquired first
+
+    static std::string MakeKey(const std::string& path, const TextureSettings& settings);
+};
+
+#endif // TEXTUREMANAGER_H
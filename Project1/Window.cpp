@@ -1,5 +1,5 @@
-#include "window.h"
-#include "renderer.h"  // Include the renderer header
+#include "Window.h"
+#include "Renderer.h"  // Include the renderer header
 #include <iostream>
 
 // Declare the external renderer pointer
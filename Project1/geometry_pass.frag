@@ -1,7 +1,6 @@
 #version 330 core
-layout (location = 0) out vec3 gPosition;
-layout (location = 1) out vec3 gNormal;
-layout (location = 2) out vec4 gAlbedoSpec;
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedoSpec;
 
 in vec2 TexCoords;
 in vec3 FragPos;
@@ -10,9 +9,22 @@ in vec3 Normal;
 uniform sampler2D texture_diffuse;
 uniform sampler2D texture_specular;
 
+// Octahedral normal encoding: project onto the octahedron |x|+|y|+|z| = 1, fold the lower
+// hemisphere over the upper one and remap to [0, 1] for the RG16 target
+vec2 OctWrap(vec2 v)
+{
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 EncodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    n.xy = n.z >= 0.0 ? n.xy : OctWrap(n.xy);
+    return n.xy * 0.5 + 0.5;
+}
+
 void main() {
-    gPosition = FragPos;
-    gNormal = normalize(Normal);
+    gNormal = EncodeNormal(normalize(Normal));
     gAlbedoSpec.rgb = texture(texture_diffuse, TexCoords).rgb;
     gAlbedoSpec.a = texture(texture_specular, TexCoords).r;
 }
@@ -1,14 +1,36 @@
-#version 330 core
+#version 430 core
 out vec4 FragColor;
 
 in vec2 TexCoords;
 
-uniform sampler2D gPosition;
+uniform sampler2D gDepth;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedoSpec;
 uniform sampler2D ssao;
-uniform sampler2D shadowMap;
-uniform mat4 lightSpaceMatrix;
+uniform sampler2D shadowMask; // Directional light shadow from shadow_mask.frag, 1 = fully shadowed. Point and spot lights cast none.
+
+// Feature switches; Renderer defines them for the variant it selects so a scene without, say, spot
+// lights or SSAO does not pay for their code
+#ifndef HAS_POINT_LIGHTS
+#define HAS_POINT_LIGHTS 1
+#endif
+#ifndef HAS_SPOT_LIGHTS
+#define HAS_SPOT_LIGHTS 1
+#endif
+#ifndef HAS_SHADOWS
+#define HAS_SHADOWS 1
+#endif
+#ifndef HAS_SSAO
+#define HAS_SSAO 1
+#endif
+
+// LightClusters::kGridX/Y/Z
+#ifndef CLUSTER_GRID_X
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+#endif
+const uvec3 clusterGridSize = uvec3(CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z);
 
 struct DirectionalLight {
     vec3 direction;
@@ -19,98 +41,47 @@ struct DirectionalLight {
 
 uniform DirectionalLight dirLight;
 
+// std430 mirrors of GPUPointLight / GPUSpotLight in LightBuffer.h; scalars are packed into .w
 struct PointLight {
-    vec3 position;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float constant;
-    float linear;
-    float quadratic;
+    vec4 positionConstant;
+    vec4 ambientLinear;
+    vec4 diffuseQuadratic;
+    vec4 specularRadius;
 };
 
-#define MAX_POINT_LIGHTS 16
-uniform int numPointLights;
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
+layout(std430, binding = 0) readonly buffer PointLightBuffer {
+    PointLight pointLights[];
+};
 
 struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float constant;
-    float linear;
-    float quadratic;
-    float cutOff;
-    float outerCutOff;
+    vec4 positionConstant;
+    vec4 directionLinear;
+    vec4 ambientQuadratic;
+    vec4 diffuseCutOff;
+    vec4 specularOuterCutOff;
+    vec4 range;
 };
 
-#define MAX_SPOT_LIGHTS 16
-uniform int numSpotLights;
-uniform SpotLight spotLights[MAX_SPOT_LIGHTS];
-
-uniform vec3 viewPos;
-
-vec3 poissonDisk[16] = vec3[](
-    vec3(-0.94201624, -0.39906216, 0.0), vec3(0.94558609, -0.76890725, 0.0),
-    vec3(-0.094184101, -0.92938870, 0.0), vec3(0.34495938, 0.29387760, 0.0),
-    vec3(-0.91588581, 0.45771432, 0.0), vec3(-0.81544232, -0.87912464, 0.0),
-    vec3(-0.38277543, 0.27676845, 0.0), vec3(0.97484398, 0.75648379, 0.0),
-    vec3(0.44323325, -0.97511554, 0.0), vec3(0.53742981, -0.47373420, 0.0),
-    vec3(-0.26496911, -0.41893023, 0.0), vec3(0.79197514, 0.19090188, 0.0),
-    vec3(-0.24188840, 0.99706507, 0.0), vec3(-0.81409955, 0.91437590, 0.0),
-    vec3(0.19984126, 0.78641367, 0.0), vec3(0.14383161, -0.14100790, 0.0)
-);
-
-float PenumbraSize(vec3 projCoords, float currentDepth, float lightSize)
-{
-    float searchRadius = 32.0 / 4096.0; // Assuming the shadow map resolution is 4096x4096
-    float blockerDepthSum = 0.0;
-    int blockerCount = 0;
-    
-    for (int i = 0; i < 16; ++i) {
-        vec2 offset = poissonDisk[i].xy * searchRadius;
-        float sampleDepth = texture(shadowMap, projCoords.xy + offset).r;
-        if (sampleDepth < currentDepth) {
-            blockerDepthSum += sampleDepth;
-            blockerCount++;
-        }
-    }
-
-    if (blockerCount > 0) {
-        float avgBlockerDepth = blockerDepthSum / blockerCount;
-        float penumbraSize = lightSize * (currentDepth - avgBlockerDepth) / avgBlockerDepth;
-        return penumbraSize;
-    }
-
-    return 0.0;
-}
-
-float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal, float lightSize)
-{
-    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
-    projCoords = projCoords * 0.5 + 0.5;
-
-    float currentDepth = projCoords.z;
-    float bias = max(0.005 * (1.0 - dot(normal, normalize(dirLight.direction))), 0.005);
-    float shadow = 0.0;
+layout(std430, binding = 1) readonly buffer SpotLightBuffer {
+    SpotLight spotLights[];
+};
 
-    float penumbraSize = PenumbraSize(projCoords, currentDepth, lightSize);
-    penumbraSize = clamp(penumbraSize, 1.0 / 4096.0, 1.0);
+// Output of cluster_cull.comp: per froxel x = first point index, y = point count, z = first spot index, w = spot count
+layout(std430, binding = 3) readonly buffer LightGridBuffer {
+    uvec4 lightGrid[];
+};
 
-    for (int i = 0; i < 16; ++i) {
-        vec2 offset = poissonDisk[i].xy * penumbraSize;
-        float sampleDepth = texture(shadowMap, projCoords.xy + offset).r;
-        shadow += currentDepth - bias > sampleDepth ? 1.0 : 0.0;
-    }
-    shadow /= 16.0;
+layout(std430, binding = 4) readonly buffer LightIndexBuffer {
+    uint lightIndices[];
+};
 
-    if (projCoords.z > 1.0)
-        shadow = 0.0;
+uniform mat4 inverseView;
+uniform mat4 inverseProjection;
+uniform vec2 clusterTileSize;
+uniform float clusterSliceScale;
+uniform float clusterSliceBias;
 
-    return shadow;
-}
+uniform vec3 viewPos;
 
 vec3 CalculateDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 fragPos, vec3 albedo, float spec, float shadow)
 {
@@ -124,66 +95,112 @@ vec3 CalculateDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir
     return (ambient + diffuse + specular) * (1.0 - shadow);
 }
 
-vec3 CalculatePointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 fragPos, vec3 albedo, float spec, float shadow)
+vec3 CalculatePointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 fragPos, vec3 albedo, float spec)
 {
-    vec3 lightDir = normalize(light.position - fragPos);
+    vec3 position = light.positionConstant.xyz;
+    float distance = length(position - fragPos);
+    if (distance > light.specularRadius.w)
+        return vec3(0.0);
+
+    vec3 lightDir = normalize(position - fragPos);
     float diff = max(dot(normal, lightDir), 0.0);
     vec3 reflectDir = reflect(-lightDir, normal);
     float specStrength = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 specular = light.specular * specStrength * spec;
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
-    vec3 ambient = light.ambient * albedo;
-    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specularRadius.xyz * specStrength * spec;
+    float attenuation = 1.0 / (light.positionConstant.w + light.ambientLinear.w * distance + light.diffuseQuadratic.w * (distance * distance));
+    vec3 ambient = light.ambientLinear.xyz * albedo;
+    vec3 diffuse = light.diffuseQuadratic.xyz * diff * albedo;
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
-    return (ambient + diffuse + specular) * (1.0 - shadow);
+    return ambient + diffuse + specular;
 }
 
-vec3 CalculateSpotLight(SpotLight light, vec3 normal, vec3 viewDir, vec3 fragPos, vec3 albedo, float spec, float shadow)
+vec3 CalculateSpotLight(SpotLight light, vec3 normal, vec3 viewDir, vec3 fragPos, vec3 albedo, float spec)
 {
-    vec3 lightDir = normalize(light.position - fragPos);
+    vec3 position = light.positionConstant.xyz;
+    float cutOff = light.diffuseCutOff.w;
+    float outerCutOff = light.specularOuterCutOff.w;
+    float distance = length(position - fragPos);
+    if (distance > light.range.x)
+        return vec3(0.0);
+
+    vec3 lightDir = normalize(position - fragPos);
     float diff = max(dot(normal, lightDir), 0.0);
     vec3 reflectDir = reflect(-lightDir, normal);
     float specStrength = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 specular = light.specular * specStrength * spec;
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
-    float theta = dot(lightDir, normalize(-light.direction));
-    float epsilon = light.cutOff - light.outerCutOff;
-    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
-    vec3 ambient = light.ambient * albedo;
-    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specularOuterCutOff.xyz * specStrength * spec;
+    float attenuation = 1.0 / (light.positionConstant.w + light.directionLinear.w * distance + light.ambientQuadratic.w * (distance * distance));
+    float theta = dot(lightDir, normalize(-light.directionLinear.xyz));
+    float epsilon = cutOff - outerCutOff;
+    float intensity = clamp((theta - outerCutOff) / epsilon, 0.0, 1.0);
+    vec3 ambient = light.ambientQuadratic.xyz * albedo;
+    vec3 diffuse = light.diffuseCutOff.xyz * diff * albedo;
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
-    return (ambient + diffuse + specular) * (1.0 - shadow);
+    return ambient + diffuse + specular;
+}
+
+uint ClusterIndex(float depth)
+{
+    int slice = int(floor(log(max(depth, 1e-4)) * clusterSliceScale - clusterSliceBias));
+    uint z = uint(clamp(slice, 0, int(clusterGridSize.z) - 1));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTileSize), clusterGridSize.xy - 1u);
+    return tile.x + clusterGridSize.x * (tile.y + clusterGridSize.y * z);
+}
+
+vec3 ViewPositionFromDepth(vec2 uv)
+{
+    float depth = texture(gDepth, uv).r;
+    vec4 position = inverseProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+vec3 DecodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
 }
 
 void main()
 {
-    vec3 fragPos = texture(gPosition, TexCoords).rgb;
-    vec3 normal = texture(gNormal, TexCoords).rgb;
+    vec3 viewSpacePos = ViewPositionFromDepth(TexCoords);
+    vec3 fragPos = (inverseView * vec4(viewSpacePos, 1.0)).xyz;
+    vec3 normal = DecodeNormal(texture(gNormal, TexCoords).rg);
     vec3 albedo = texture(gAlbedoSpec, TexCoords).rgb;
     float spec = texture(gAlbedoSpec, TexCoords).a;
-    float ao = texture(ssao, TexCoords).r;
 
     vec3 viewDir = normalize(viewPos - fragPos);
-    vec4 fragPosLightSpace = lightSpaceMatrix * vec4(fragPos, 1.0);
-    float shadow = ShadowCalculation(fragPosLightSpace, normal, 0.05); // Adjust the light size as needed
+#if HAS_SHADOWS
+    float shadow = texture(shadowMask, TexCoords).r;
+#else
+    float shadow = 0.0;
+#endif
 
     vec3 result = vec3(0.0);
     result += CalculateDirectionalLight(dirLight, normal, viewDir, fragPos, albedo, spec, shadow);
 
-    for (int i = 0; i < numPointLights; i++) {
-        result += CalculatePointLight(pointLights[i], normal, viewDir, fragPos, albedo, spec, shadow);
+#if HAS_POINT_LIGHTS || HAS_SPOT_LIGHTS
+    // Only the lights binned into this fragment's froxel can reach it
+    uvec4 cluster = lightGrid[ClusterIndex(-viewSpacePos.z)];
+#endif
+#if HAS_POINT_LIGHTS
+    for (uint i = 0u; i < cluster.y; i++) {
+        result += CalculatePointLight(pointLights[lightIndices[cluster.x + i]], normal, viewDir, fragPos, albedo, spec);
     }
-
-    for (int i = 0; i < numSpotLights; i++) {
-        result += CalculateSpotLight(spotLights[i], normal, viewDir, fragPos, albedo, spec, shadow);
+#endif
+#if HAS_SPOT_LIGHTS
+    for (uint i = 0u; i < cluster.w; i++) {
+        result += CalculateSpotLight(spotLights[lightIndices[cluster.z + i]], normal, viewDir, fragPos, albedo, spec);
     }
+#endif
 
-    result *= ao;
+#if HAS_SSAO
+    result *= texture(ssao, TexCoords).r;
+#endif
     FragColor = vec4(result, 1.0);
 }
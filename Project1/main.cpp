@@ -1,58 +1,36 @@
 #include <iostream>
-#include "window.h"
-#include "inputmanager.h"
-#include "renderer.h"
-#include "camera.h"
-#include "scene.h"
-#include "mesh.h"
-#include "texture.h"
+#include "Window.h"
+#include "InputManager.h"
+#include "Renderer.h"
+#include "Camera.h"
+#include "Scene.h"
+#include "Mesh.h"
+#include "GeometryArena.h"
+#include "Texture.h"
+#include "TextureLoader.h"
+#include "TextureManager.h"
+#include "Primitives.h"
+#include "ScenePackage.h"
+#include "Benchmark.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cstring>
 
 
 // Define the global renderer pointer
 Renderer* renderer = nullptr;
 
-// Vertex data for a cube
-std::vector<Vertex> vertices = {
-    {{-0.5f, -0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f}},
-    {{0.5f, -0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f}},
-    {{0.5f,  0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {1.0f, 1.0f}},
-    {{-0.5f,  0.5f, -0.5f}, {0.0f, 0.0f, -1.0f}, {0.0f, 1.0f}},
-    {{-0.5f, -0.5f,  0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
-    {{0.5f, -0.5f,  0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}},
-    {{0.5f,  0.5f,  0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
-    {{-0.5f,  0.5f,  0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
-    {{-0.5f,  0.5f,  0.5f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
-    {{-0.5f,  0.5f, -0.5f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},
-    {{-0.5f, -0.5f, -0.5f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-    {{-0.5f, -0.5f,  0.5f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
-    {{0.5f,  0.5f,  0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
-    {{0.5f,  0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},
-    {{0.5f, -0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-    {{0.5f, -0.5f,  0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
-    {{-0.5f, -0.5f, -0.5f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}},
-    {{0.5f, -0.5f, -0.5f}, {0.0f, -1.0f, 0.0f}, {1.0f, 0.0f}},
-    {{0.5f, -0.5f,  0.5f}, {0.0f, -1.0f, 0.0f}, {1.0f, 1.0f}},
-    {{-0.5f, -0.5f,  0.5f}, {0.0f, -1.0f, 0.0f}, {0.0f, 1.0f}},
-    {{-0.5f,  0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f}},
-    {{0.5f,  0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f}},
-    {{0.5f,  0.5f,  0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
-    {{-0.5f,  0.5f,  0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}}
-};
-
-// Index data for a cube
-std::vector<unsigned int> indices = {
-    0, 1, 2, 2, 3, 0,  // -Z
-    4, 5, 6, 6, 7, 4,  // +Z
-    8, 9, 10, 10, 11, 8,  // -X
-    12, 13, 14, 14, 15, 12,  // +X
-    16, 17, 18, 18, 19, 16,  // -Y
-    20, 21, 22, 22, 23, 20   // +Y
-};
-
-int main() {
+int main(int argc, char** argv) {
+    // --benchmark runs a scripted offscreen workload instead of the interactive viewer
+    if (IsBenchmarkRequested(argc, argv)) {
+        BenchmarkConfig config;
+        if (!ParseBenchmarkArgs(argc, argv, config)) {
+            return 1;
+        }
+        return RunBenchmark(config);
+    }
+
     Window window("Deferred Rendering", 800, 600);
     InputManager inputManager;
     inputManager.setWindow(window.getGLFWwindow());
@@ -69,25 +47,47 @@ int main() {
     Scene scene;
 
 
-    // Load textures
-    Texture diffuseTexture("Assets/Textures/StoneFloor/BC.jpg", "texture_diffuse");
-    Texture specularTexture("Assets/Textures/StoneFloor/AO.jpg", "texture_specular");
-    std::vector<Texture> textures = { diffuseTexture, specularTexture };
+    // Load textures in the background; they show a placeholder until uploaded
+    TextureLoader textureLoader;
+    TextureManager textureManager(textureLoader);
 
-    // Create a cube mesh and add it to the scene
-    Mesh cubeMesh(vertices, indices, textures);
-    scene.AddMesh(cubeMesh);
-
-    // Set up lights
+    // --scene loads a package built by ScenePacker instead of the demo cube
+    const char* scenePath = nullptr;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--scene") == 0) {
+            scenePath = argv[i + 1];
+        }
+    }
 
-    glm::vec3 lightPos(0.0f, 10.0f, 0.0f);
-    glm::vec3 lightDir(-0.2f, -1.0f, -0.3f);
-    glm::vec3 ambient(0.05f, 0.05f, 0.05f);
-    glm::vec3 diffuse(0.4f, 0.4f, 0.4f);
-    glm::vec3 specular(0.5f, 0.5f, 0.5f);
-    scene.SetDirectionalLight(lightPos, lightDir, ambient, diffuse, specular);
-    //scene.AddPointLight(glm::vec3(0.7f, 0.2f, 2.0f), glm::vec3(0.05f, 0.05f, 0.05f), glm::vec3(0.8f, 0.8f, 0.8f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f, 0.09f, 0.032f);
-    //scene.SetSpotLight(camera.GetPosition(), camera.GetFront(), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f, 0.09f, 0.032f, glm::cos(glm::radians(12.5f)), glm::cos(glm::radians(15.0f)));
+    if (scenePath) {
+        // Geometry is uploaded straight from the mapping, which can go once loading is done
+        ScenePackage scenePackage;
+        if (!scenePackage.Open(scenePath)) {
+            GeometryArena::Shutdown();
+            return 1;
+        }
+        scenePackage.Load(scene, textureManager);
+    }
+    else {
+        Texture diffuseTexture = textureManager.Acquire("Assets/Textures/StoneFloor/BC.jpg", "texture_diffuse");
+        Texture specularTexture = textureManager.Acquire("Assets/Textures/StoneFloor/AO.jpg", "texture_specular");
+        std::vector<Texture> textures = { diffuseTexture, specularTexture };
+
+        // Create a cube mesh and add it to the scene
+        Mesh cubeMesh(cubeVertices, cubeIndices, textures);
+        scene.AddObject(scene.AddMesh(cubeMesh));
+
+        // Set up lights
+
+        glm::vec3 lightPos(0.0f, 10.0f, 0.0f);
+        glm::vec3 lightDir(-0.2f, -1.0f, -0.3f);
+        glm::vec3 ambient(0.05f, 0.05f, 0.05f);
+        glm::vec3 diffuse(0.4f, 0.4f, 0.4f);
+        glm::vec3 specular(0.5f, 0.5f, 0.5f);
+        scene.SetDirectionalLight(lightPos, lightDir, ambient, diffuse, specular);
+        //scene.AddPointLight(glm::vec3(0.7f, 0.2f, 2.0f), glm::vec3(0.05f, 0.05f, 0.05f), glm::vec3(0.8f, 0.8f, 0.8f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f, 0.09f, 0.032f);
+        //scene.SetSpotLight(camera.GetPosition(), camera.GetFront(), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f, 0.09f, 0.032f, glm::cos(glm::radians(12.5f)), glm::cos(glm::radians(15.0f)));
+    }
 
     // Ensure the correct winding order
     glFrontFace(GL_CCW);
@@ -102,10 +102,23 @@ int main() {
         lastFrame = currentFrame;
 
         inputManager.update();
+        textureLoader.Update();
+        textureManager.Update();
 
         if (inputManager.isKeyPressed(GLFW_KEY_ESCAPE)) {
             glfwSetWindowShouldClose(window.getGLFWwindow(), true);
         }
+
+        // F1 dumps per-pass timings and a Chrome/Perfetto trace of the last few hundred frames
+        static bool profileKeyWasDown = false;
+        bool profileKeyDown = inputManager.isKeyPressed(GLFW_KEY_F1);
+        if (profileKeyDown && !profileKeyWasDown) {
+            renderer->GetProfiler().PrintPassStats(std::cout);
+            if (renderer->GetProfiler().WriteChromeTrace("profile_trace.json")) {
+                std::cout << "Wrote profile_trace.json" << std::endl;
+            }
+        }
+        profileKeyWasDown = profileKeyDown;
         if (inputManager.isKeyPressed(GLFW_KEY_W)) {
             camera.ProcessKeyboardInput(deltaTime, true, false, false, false);
         }
@@ -133,5 +146,6 @@ int main() {
         window.pollEvents();
     }
 
+    GeometryArena::Shutdown(); // While the window's context is still current
     return 0;
 }
@@ -1,10 +1,13 @@
 #version 330 core
 layout(location = 0) in vec3 aPos;
+layout(location = 3) in mat4 aModel; // Per instance
+layout(location = 7) in vec3 aPositionOffset; // Per instance: dequantises compact positions
+layout(location = 8) in vec3 aPositionScale;
 
 uniform mat4 lightSpaceMatrix;
-uniform mat4 model;
 
 void main()
 {
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    vec3 position = aPositionOffset + aPositionScale * aPos;
+    gl_Position = lightSpaceMatrix * aModel * vec4(position, 1.0);
 }
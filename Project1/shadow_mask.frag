@@ -0,0 +1,202 @@
+#version 430 core
+out vec2 FragColor; // Shadow (1 = fully shadowed), frames accumulated
+
+in vec2 TexCoords;
+
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
+uniform sampler2DArray shadowMap;              // Raw depth (nearest, no comparison)
+uniform sampler2DArrayShadow shadowMapCompare; // The same texture through a comparison sampler
+uniform sampler2D history;       // Last frame's output
+uniform sampler2D previousDepth; // Last frame's G-buffer depth
+
+// Filtering tiers; Renderer defines SHADOW_FILTER, SHADOW_SAMPLES and CASCADE_COUNT from ShadowSettings
+// for the variant it selects
+#define SHADOW_FILTER_HARD 0
+#define SHADOW_FILTER_PCF 1
+#define SHADOW_FILTER_GATHER 2
+#define SHADOW_FILTER_PCSS 3
+#ifndef SHADOW_FILTER
+#define SHADOW_FILTER SHADOW_FILTER_PCSS
+#endif
+
+// Renderer::kShadowCascadeCount
+#ifndef CASCADE_COUNT
+#define CASCADE_COUNT 4
+#endif
+// PCSS blocker search and filter taps per pixel, at most 16
+#ifndef SHADOW_SAMPLES
+#define SHADOW_SAMPLES 4
+#endif
+uniform mat4 cascadeMatrices[CASCADE_COUNT];
+uniform float cascadeSplits[CASCADE_COUNT]; // View depth where each cascade ends
+
+uniform vec3 lightDirection;
+uniform mat4 inverseView;
+uniform mat4 inverseProjection;
+uniform float frameRotation;    // Turns the Poisson disk so each frame tests a different sample set
+uniform bool temporal;          // Blend with the reprojected history
+uniform mat4 viewToPreviousClip;
+uniform mat4 previousInverseProjection;
+
+const float kLightSize = 0.05;
+// Each frame contributes at least 1/kMaxHistory of the result
+const float kMaxHistory = 16.0;
+// History whose depth differs more than this, relative to the expected depth, was disoccluded
+const float kDisocclusionTolerance = 0.05;
+
+vec2 poissonDisk[16] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725),
+    vec2(-0.094184101, -0.92938870), vec2(0.34495938, 0.29387760),
+    vec2(-0.91588581, 0.45771432), vec2(-0.81544232, -0.87912464),
+    vec2(-0.38277543, 0.27676845), vec2(0.97484398, 0.75648379),
+    vec2(0.44323325, -0.97511554), vec2(0.53742981, -0.47373420),
+    vec2(-0.26496911, -0.41893023), vec2(0.79197514, 0.19090188),
+    vec2(-0.24188840, 0.99706507), vec2(-0.81409955, 0.91437590),
+    vec2(0.19984126, 0.78641367), vec2(0.14383161, -0.14100790)
+);
+
+// Per-pixel rotation noise (Jimenez 2014); neighbouring pixels get well spread angles
+float InterleavedGradientNoise(vec2 pixel)
+{
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+float HardShadow(vec3 projCoords, float layer, float reference)
+{
+    return texture(shadowMap, vec3(projCoords.xy, layer)).r < reference ? 1.0 : 0.0;
+}
+
+// Four bilinear comparison taps half a texel apart: a 3x3 tent for four fetches
+float PCFShadow(vec3 projCoords, float layer, float reference)
+{
+    vec2 texel = 1.0 / vec2(textureSize(shadowMapCompare, 0).xy);
+    float lit = 0.0;
+    lit += texture(shadowMapCompare, vec4(projCoords.xy + vec2(-0.5, -0.5) * texel, layer, reference));
+    lit += texture(shadowMapCompare, vec4(projCoords.xy + vec2(0.5, -0.5) * texel, layer, reference));
+    lit += texture(shadowMapCompare, vec4(projCoords.xy + vec2(-0.5, 0.5) * texel, layer, reference));
+    lit += texture(shadowMapCompare, vec4(projCoords.xy + vec2(0.5, 0.5) * texel, layer, reference));
+    return 1.0 - lit * 0.25;
+}
+
+// Four gathers around the nearest texel corner: 16 comparisons covering a 4x4 block
+float GatherShadow(vec3 projCoords, float layer, float reference)
+{
+    vec2 size = vec2(textureSize(shadowMapCompare, 0).xy);
+    vec2 corner = round(projCoords.xy * size) / size;
+    float lit = 0.0;
+    lit += dot(textureGather(shadowMapCompare, vec3(corner + vec2(-1.0, -1.0) / size, layer), reference), vec4(1.0));
+    lit += dot(textureGather(shadowMapCompare, vec3(corner + vec2(1.0, -1.0) / size, layer), reference), vec4(1.0));
+    lit += dot(textureGather(shadowMapCompare, vec3(corner + vec2(-1.0, 1.0) / size, layer), reference), vec4(1.0));
+    lit += dot(textureGather(shadowMapCompare, vec3(corner + vec2(1.0, 1.0) / size, layer), reference), vec4(1.0));
+    return 1.0 - lit / 16.0;
+}
+
+// Percentage-closer soft shadows. A blocker search that finds every tap or none of them decides
+// the result on its own, so only penumbra pixels pay for the filter taps.
+float PCSSShadow(vec3 projCoords, float layer, float reference, mat2 rotation)
+{
+    float searchRadius = 32.0 / float(textureSize(shadowMap, 0).x);
+    float blockerDepthSum = 0.0;
+    int blockerCount = 0;
+    for (int i = 0; i < SHADOW_SAMPLES; ++i) {
+        vec2 offset = rotation * poissonDisk[i] * searchRadius;
+        float sampleDepth = texture(shadowMap, vec3(projCoords.xy + offset, layer)).r;
+        if (sampleDepth < reference) {
+            blockerDepthSum += sampleDepth;
+            blockerCount++;
+        }
+    }
+    if (blockerCount == 0)
+        return 0.0;
+    if (blockerCount == SHADOW_SAMPLES)
+        return 1.0;
+
+    float avgBlockerDepth = blockerDepthSum / blockerCount;
+    float penumbraSize = kLightSize * (reference - avgBlockerDepth) / avgBlockerDepth;
+    penumbraSize = clamp(penumbraSize, 1.0 / float(textureSize(shadowMap, 0).x), 1.0);
+
+    float lit = 0.0;
+    for (int i = 0; i < SHADOW_SAMPLES; ++i) {
+        vec2 offset = rotation * poissonDisk[i] * penumbraSize;
+        lit += texture(shadowMapCompare, vec4(projCoords.xy + offset, layer, reference));
+    }
+    return 1.0 - lit / float(SHADOW_SAMPLES);
+}
+
+float ShadowCalculation(vec3 fragPos, float viewDepth, vec3 normal, mat2 rotation)
+{
+    int cascade = 0;
+    while (cascade < CASCADE_COUNT - 1 && viewDepth > cascadeSplits[cascade])
+        cascade++;
+    if (viewDepth > cascadeSplits[CASCADE_COUNT - 1])
+        return 0.0; // Past the last cascade
+    float layer = float(cascade);
+
+    vec4 fragPosLightSpace = cascadeMatrices[cascade] * vec4(fragPos, 1.0);
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    projCoords = projCoords * 0.5 + 0.5;
+    if (projCoords.z > 1.0)
+        return 0.0;
+
+    float bias = max(0.005 * (1.0 - dot(normal, normalize(lightDirection))), 0.005);
+    float reference = projCoords.z - bias;
+
+#if SHADOW_FILTER == SHADOW_FILTER_HARD
+    return HardShadow(projCoords, layer, reference);
+#elif SHADOW_FILTER == SHADOW_FILTER_PCF
+    return PCFShadow(projCoords, layer, reference);
+#elif SHADOW_FILTER == SHADOW_FILTER_GATHER
+    return GatherShadow(projCoords, layer, reference);
+#else
+    return PCSSShadow(projCoords, layer, reference, rotation);
+#endif
+}
+
+vec3 ViewPositionFromDepth(mat4 inverseProj, float depth, vec2 uv)
+{
+    vec4 position = inverseProj * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+vec3 DecodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main()
+{
+    float depth = texture(gDepth, TexCoords).r;
+    if (depth == 1.0) {
+        FragColor = vec2(0.0, 1.0); // Background: nothing to shadow or reproject
+        return;
+    }
+    vec3 viewSpacePos = ViewPositionFromDepth(inverseProjection, depth, TexCoords);
+    vec3 fragPos = (inverseView * vec4(viewSpacePos, 1.0)).xyz;
+    vec3 normal = DecodeNormal(texture(gNormal, TexCoords).rg);
+
+    float angle = frameRotation + 6.2831853 * InterleavedGradientNoise(gl_FragCoord.xy);
+    float c = cos(angle);
+    float s = sin(angle);
+    float shadow = ShadowCalculation(fragPos, -viewSpacePos.z, normal, mat2(c, s, -s, c));
+
+    float frames = 1.0;
+    if (temporal) {
+        // w of last frame's clip position is the view depth this surface had then
+        vec4 previousClip = viewToPreviousClip * vec4(viewSpacePos, 1.0);
+        vec2 previousUV = previousClip.xy / previousClip.w * 0.5 + 0.5;
+        if (previousClip.w > 0.0 && all(greaterThanEqual(previousUV, vec2(0.0))) && all(lessThanEqual(previousUV, vec2(1.0)))) {
+            float previousViewDepth = -ViewPositionFromDepth(previousInverseProjection, texture(previousDepth, previousUV).r, previousUV).z;
+            if (abs(previousViewDepth - previousClip.w) < kDisocclusionTolerance * previousClip.w) {
+                vec2 previous = texture(history, previousUV).rg;
+                frames = min(previous.g + 1.0, kMaxHistory);
+                shadow = mix(previous.r, shadow, 1.0 / frames);
+            }
+        }
+    }
+    FragColor = vec2(shadow, frames);
+}
@@ -1,43 +1,91 @@
 #version 330 core
-out float FragColor;
+out vec2 FragColor; // Occlusion, frames accumulated
 
 in vec2 TexCoords;
 
-uniform sampler2D gPosition;
-uniform sampler2D gNormal;
+uniform sampler2D viewDepth;  // Linear view depth from ssao_downsample.frag
+uniform sampler2D viewNormal; // Octahedral view-space normal
 uniform sampler2D texNoise;
-uniform vec3 samples[64];
+uniform sampler2D history;      // Last frame's output
+uniform sampler2D historyDepth; // Last frame's viewDepth
+
+// Uploaded once by SSAO::UploadKernel; only the first sampleCount entries are used
+layout(std140) uniform SSAOKernel {
+    vec4 samples[64];
+};
+
+uniform int sampleCount;
 uniform mat4 projection;
+uniform vec2 viewRayScale;
+uniform vec2 noiseScale; // Target size / noise texture size
+uniform float radius;
+uniform float bias;
+uniform float frameRotation;    // Turns the noise so each frame tests a different sample set
+uniform bool temporal;          // Blend with the reprojected history
+uniform mat4 viewToPreviousClip;
 
-const float radius = 0.5;
-const float bias = 0.025;
-const vec2 noiseScale = vec2(800.0f/4.0f, 600.0f/4.0f);
+// Each frame contributes at least 1/kMaxHistory of the result
+const float kMaxHistory = 16.0;
+// History whose depth differs more than this, relative to the expected depth, was disoccluded
+const float kDisocclusionTolerance = 0.05;
+
+vec3 ViewPosition(vec2 uv, float depth)
+{
+    return vec3((uv * 2.0 - 1.0) * viewRayScale * depth, -depth);
+}
+
+vec3 DecodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
 
 void main()
 {
-    vec3 fragPos = texture(gPosition, TexCoords).xyz;
-    vec3 normal = normalize(texture(gNormal, TexCoords).xyz);
-    vec3 randomVec = normalize(texture(texNoise, TexCoords * noiseScale).xyz);
-    
+    vec3 fragPos = ViewPosition(TexCoords, texture(viewDepth, TexCoords).r);
+    vec3 normal = DecodeNormal(texture(viewNormal, TexCoords).rg);
+    vec2 noise = texture(texNoise, TexCoords * noiseScale).xy;
+    float c = cos(frameRotation);
+    float s = sin(frameRotation);
+    vec3 randomVec = normalize(vec3(c * noise.x - s * noise.y, s * noise.x + c * noise.y, 0.0));
+
     vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
     vec3 bitangent = cross(normal, tangent);
     mat3 TBN = mat3(tangent, bitangent, normal);
-    
+
     float occlusion = 0.0;
-    for (int i = 0; i < 64; ++i)
+    for (int i = 0; i < sampleCount; ++i)
     {
-        vec3 sample = TBN * samples[i];
+        vec3 sample = TBN * samples[i].xyz;
         sample = fragPos + sample * radius;
-        
+
         vec4 offset = vec4(sample, 1.0);
         offset = projection * offset;
         offset.xyz /= offset.w;
         offset.xyz = offset.xyz * 0.5 + 0.5;
-        
-        float sampleDepth = texture(gPosition, offset.xy).z;
+
+        float sampleDepth = -texture(viewDepth, offset.xy).r;
         float rangeCheck = smoothstep(0.0, 1.0, radius / abs(fragPos.z - sampleDepth));
         occlusion += (sampleDepth >= sample.z + bias ? 1.0 : 0.0) * rangeCheck;
     }
-    occlusion = 1.0 - (occlusion / 64.0);
-    FragColor = occlusion;
+    occlusion = 1.0 - (occlusion / float(sampleCount));
+
+    float frames = 1.0;
+    if (temporal) {
+        // w of last frame's clip position is the view depth this surface had then
+        vec4 previousClip = viewToPreviousClip * vec4(fragPos, 1.0);
+        vec2 previousUV = previousClip.xy / previousClip.w * 0.5 + 0.5;
+        if (previousClip.w > 0.0 && all(greaterThanEqual(previousUV, vec2(0.0))) && all(lessThanEqual(previousUV, vec2(1.0)))) {
+            float previousDepth = texture(historyDepth, previousUV).r;
+            if (abs(previousDepth - previousClip.w) < kDisocclusionTolerance * previousClip.w) {
+                vec2 previous = texture(history, previousUV).rg;
+                frames = min(previous.g + 1.0, kMaxHistory);
+                occlusion = mix(previous.r, occlusion, 1.0 / frames);
+            }
+        }
+    }
+    FragColor = vec2(occlusion, frames);
 }
@@ -4,18 +4,46 @@ out float FragColor;
 in vec2 TexCoords;
 
 uniform sampler2D ssaoInput;
+uniform sampler2D viewDepth;
+uniform sampler2D viewNormal;
+uniform vec2 direction; // (1, 0) for the horizontal pass, (0, 1) for the vertical one
+
+// 9 taps per pass; Gaussian with sigma = kRadius / 2
+const int kRadius = 4;
+// Depth differences are judged relative to the centre's depth, so the tolerance follows perspective
+const float kDepthTolerance = 0.02;
+const float kNormalPower = 8.0;
+
+vec3 DecodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
 
 void main()
 {
-    vec2 texelSize = 1.0 / textureSize(ssaoInput, 0);
+    ivec2 size = textureSize(ssaoInput, 0);
+    ivec2 center = ivec2(gl_FragCoord.xy);
+    float centerDepth = texelFetch(viewDepth, center, 0).r;
+    vec3 centerNormal = DecodeNormal(texelFetch(viewNormal, center, 0).rg);
+    float tolerance = centerDepth * kDepthTolerance + 1e-4;
+
     float result = 0.0;
-    for (int x = -2; x <= 2; ++x)
+    float weightSum = 0.0;
+    for (int i = -kRadius; i <= kRadius; ++i)
     {
-        for (int y = -2; y <= 2; ++y)
-        {
-            vec2 offset = vec2(float(x), float(y)) * texelSize;
-            result += texture(ssaoInput, TexCoords + offset).r;
-        }
+        ivec2 texel = clamp(center + ivec2(direction) * i, ivec2(0), size - 1);
+        float depth = texelFetch(viewDepth, texel, 0).r;
+        vec3 normal = DecodeNormal(texelFetch(viewNormal, texel, 0).rg);
+
+        float weight = exp(-float(i * i) / float(kRadius * kRadius / 2));
+        weight *= exp(-abs(depth - centerDepth) / tolerance);
+        weight *= pow(max(dot(normal, centerNormal), 0.0), kNormalPower);
+        result += texelFetch(ssaoInput, texel, 0).r * weight;
+        weightSum += weight;
     }
-    FragColor = result / (5.0 * 5.0);
+    FragColor = result / weightSum; // The centre tap always has weight 1
 }
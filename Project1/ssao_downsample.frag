@@ -0,0 +1,59 @@
+#version 330 core
+layout (location = 0) out float viewDepthOut;
+layout (location = 1) out vec2 viewNormalOut;
+
+in vec2 TexCoords;
+
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
+uniform mat4 inverseProjection;
+uniform mat4 view;
+uniform int divisor; // Full-resolution texels per low-resolution texel along each axis
+
+vec2 OctWrap(vec2 v)
+{
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 EncodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    n.xy = n.z >= 0.0 ? n.xy : OctWrap(n.xy);
+    return n.xy * 0.5 + 0.5;
+}
+
+vec3 DecodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main()
+{
+    // Keep the nearest sample of the block rather than averaging, so silhouettes stay sharp and
+    // depth and normal come from the same surface
+    ivec2 size = textureSize(gDepth, 0);
+    ivec2 base = ivec2(gl_FragCoord.xy) * divisor;
+    ivec2 nearestTexel = min(base, size - 1);
+    float nearestDepth = texelFetch(gDepth, nearestTexel, 0).r;
+    for (int y = 0; y < divisor; ++y) {
+        for (int x = 0; x < divisor; ++x) {
+            ivec2 texel = min(base + ivec2(x, y), size - 1);
+            float depth = texelFetch(gDepth, texel, 0).r;
+            if (depth < nearestDepth) {
+                nearestDepth = depth;
+                nearestTexel = texel;
+            }
+        }
+    }
+
+    vec2 uv = (vec2(nearestTexel) + 0.5) / vec2(size);
+    vec4 position = inverseProjection * vec4(vec3(uv, nearestDepth) * 2.0 - 1.0, 1.0);
+    viewDepthOut = -position.z / position.w;
+
+    vec3 normal = DecodeNormal(texelFetch(gNormal, nearestTexel, 0).rg);
+    viewNormalOut = EncodeNormal(normalize(mat3(view) * normal));
+}
@@ -0,0 +1,50 @@
+#version 330 core
+out float FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D ssaoInput; // Blurred low-resolution occlusion
+uniform sampler2D viewDepth; // Low-resolution linear depth it was computed from
+uniform sampler2D gDepth;    // Full-resolution depth buffer
+uniform mat4 inverseProjection;
+
+const float kDepthTolerance = 0.02;
+
+void main()
+{
+    vec4 position = inverseProjection * vec4(vec3(TexCoords, texture(gDepth, TexCoords).r) * 2.0 - 1.0, 1.0);
+    float depth = -position.z / position.w;
+    float tolerance = depth * kDepthTolerance + 1e-4;
+
+    // Bilinear weights over the four nearest low-resolution texels, each scaled down by how far
+    // its depth is from this pixel's, so occlusion does not leak across silhouettes
+    ivec2 size = textureSize(ssaoInput, 0);
+    vec2 coord = TexCoords * vec2(size) - 0.5;
+    ivec2 base = ivec2(floor(coord));
+    vec2 f = fract(coord);
+
+    float result = 0.0;
+    float weightSum = 0.0;
+    float closestDifference = 1e30;
+    float closestOcclusion = 1.0;
+    for (int i = 0; i < 4; ++i)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(base + offset, ivec2(0), size - 1);
+        float occlusion = texelFetch(ssaoInput, texel, 0).r;
+        float difference = abs(texelFetch(viewDepth, texel, 0).r - depth);
+
+        vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+        float weight = bilinear.x * bilinear.y * exp(-difference / tolerance);
+        result += occlusion * weight;
+        weightSum += weight;
+
+        if (difference < closestDifference) {
+            closestDifference = difference;
+            closestOcclusion = occlusion;
+        }
+    }
+
+    // No tap on this surface: fall back to the one nearest in depth
+    FragColor = weightSum > 1e-4 ? result / weightSum : closestOcclusion;
+}
@@ -0,0 +1,163 @@
+#include "ObjLoader.h"
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+struct Float3 {
+    float x, y, z;
+};
+
+struct CornerKey {
+    int position, texCoord, normal;
+
+    bool operator==(const CornerKey& other) const {
+        return position == other.position && texCoord == other.texCoord && normal == other.normal;
+    }
+};
+
+struct CornerKeyHash {
+    size_t operator()(const CornerKey& key) const {
+        return ((size_t)key.position * 73856093u) ^ ((size_t)key.texCoord * 19349663u) ^ ((size_t)key.normal * 83492791u);
+    }
+};
+
+// OBJ indices are 1-based, negative ones count back from the end; returns -1 if absent or out of range
+int ResolveIndex(const std::string& text, size_t count) {
+    if (text.empty())
+        return -1;
+    long index = std::strtol(text.c_str(), nullptr, 10);
+    if (index < 0)
+        index += (long)count;
+    else
+        index -= 1;
+    return (index >= 0 && (size_t)index < count) ? (int)index : -1;
+}
+
+Float3 Cross(const Float3& a, const Float3& b) {
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+Float3 Sub(const float* a, const float* b) {
+    return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+}
+
+} // namespace
+
+bool LoadObj(const std::string& path, ObjMesh& mesh) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    std::vector<Float3> positions;
+    std::vector<Float3> normals;
+    std::vector<Float3> texCoords;
+    std::unordered_map<CornerKey, uint32_t, CornerKeyHash> corners;
+    std::vector<bool> needsNormal;
+    std::vector<uint32_t> face;
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::istringstream stream(line);
+        std::string keyword;
+        stream >> keyword;
+
+        if (keyword == "v" || keyword == "vn" || keyword == "vt") {
+            Float3 value = { 0.0f, 0.0f, 0.0f };
+            stream >> value.x >> value.y >> value.z;
+            if (keyword == "v")
+                positions.push_back(value);
+            else if (keyword == "vn")
+                normals.push_back(value);
+            else
+                texCoords.push_back(value);
+        }
+        else if (keyword == "f") {
+            face.clear();
+            std::string corner;
+            while (stream >> corner) {
+                size_t firstSlash = corner.find('/');
+                size_t secondSlash = firstSlash == std::string::npos ? std::string::npos : corner.find('/', firstSlash + 1);
+
+                CornerKey key;
+                key.position = ResolveIndex(corner.substr(0, firstSlash), positions.size());
+                key.texCoord = firstSlash == std::string::npos ? -1 :
+                    ResolveIndex(corner.substr(firstSlash + 1, secondSlash - firstSlash - 1), texCoords.size());
+                key.normal = secondSlash == std::string::npos ? -1 : ResolveIndex(corner.substr(secondSlash + 1), normals.size());
+                if (key.position < 0) {
+                    std::cerr << path << ":" << lineNumber << ": bad face index " << corner << std::endl;
+                    return false;
+                }
+
+                auto found = corners.find(key);
+                if (found == corners.end()) {
+                    PackageVertex vertex = {};
+                    const Float3& position = positions[key.position];
+                    vertex.position[0] = position.x;
+                    vertex.position[1] = position.y;
+                    vertex.position[2] = position.z;
+                    if (key.normal >= 0) {
+                        vertex.normal[0] = normals[key.normal].x;
+                        vertex.normal[1] = normals[key.normal].y;
+                        vertex.normal[2] = normals[key.normal].z;
+                    }
+                    if (key.texCoord >= 0) {
+                        vertex.texCoords[0] = texCoords[key.texCoord].x;
+                        vertex.texCoords[1] = texCoords[key.texCoord].y;
+                    }
+                    found = corners.emplace(key, (uint32_t)mesh.vertices.size()).first;
+                    mesh.vertices.push_back(vertex);
+                    needsNormal.push_back(key.normal < 0);
+                }
+                face.push_back(found->second);
+            }
+
+            for (size_t i = 2; i < face.size(); ++i) {
+                mesh.indices.push_back(face[0]);
+                mesh.indices.push_back(face[i - 1]);
+                mesh.indices.push_back(face[i]);
+            }
+        }
+    }
+
+    // Accumulate unnormalised face normals (length = twice the area) into corners that had none
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        const float* a = mesh.vertices[mesh.indices[i]].position;
+        const float* b = mesh.vertices[mesh.indices[i + 1]].position;
+        const float* c = mesh.vertices[mesh.indices[i + 2]].position;
+        Float3 normal = Cross(Sub(b, a), Sub(c, a));
+        for (size_t corner = 0; corner < 3; ++corner) {
+            uint32_t index = mesh.indices[i + corner];
+            if (!needsNormal[index])
+                continue;
+            mesh.vertices[index].normal[0] += normal.x;
+            mesh.vertices[index].normal[1] += normal.y;
+            mesh.vertices[index].normal[2] += normal.z;
+        }
+    }
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        if (!needsNormal[i])
+            continue;
+        float* normal = mesh.vertices[i].normal;
+        float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length > 0.0f) {
+            normal[0] /= length;
+            normal[1] /= length;
+            normal[2] /= length;
+        }
+    }
+
+    if (mesh.indices.empty()) {
+        std::cerr << path << " has no faces" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,19 @@
+#ifndef OBJLOADER_H
+#define OBJLOADER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Project1/ScenePackageFormat.h"
+
+struct ObjMesh {
+    std::vector<PackageVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// Reads positions, normals and texture coordinates from a Wavefront OBJ, triangulating polygons
+// as fans and merging corners that share the same v/vt/vn triple. Corners without a normal get
+// the area-weighted average of their faces' normals.
+bool LoadObj(const std::string& path, ObjMesh& mesh);
+
+#endif // OBJLOADER_H
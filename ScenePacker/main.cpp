@@ -0,0 +1,377 @@
+#include "ObjLoader.h"
+#include "../Project1/ScenePackageFormat.h"
+#include "../Project1/MeshOptimizer.h"
+#include "../Project1/MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Offline scene packer: turns a text manifest and the OBJ files it names into one .gspk package
+// that the engine maps and uploads without parsing (see ScenePackage). Meshes are welded and
+// reordered for the vertex cache, overdraw and vertex fetch on the way in, and get their LOD
+// chain generated.
+//
+//   ScenePacker manifest.txt output.gspk
+//
+// Manifest lines ('#' starts a comment, paths are relative to the working directory):
+//   mesh <name> <file.obj>
+//   texture <type> <path>                     adds a texture to the last mesh, e.g. texture_diffuse
+//   object <mesh> <tx ty tz> [rx ry rz [sx sy sz]]   rotation in degrees, applied X, then Y, then Z
+//   directional <position> <direction> <ambient> <diffuse> <specular>
+//   point <position> <ambient> <diffuse> <specular> <constant linear quadratic>
+//   spot <position> <direction> <ambient> <diffuse> <specular> <constant linear quadratic> <inner outer degrees>
+
+namespace {
+
+struct PackedMesh {
+    std::string name;
+    ObjMesh geometry;
+    std::vector<MeshLod> lods;
+    std::vector<std::pair<std::string, std::string>> textures; // type, path
+};
+
+struct Manifest {
+    std::vector<PackedMesh> meshes;
+    std::vector<PackageObject> objects;
+    std::vector<PackageLight> lights;
+};
+
+const float kDegreesToRadians = 3.14159265358979f / 180.0f;
+
+bool ReadFloats(std::istream& stream, float* values, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (!(stream >> values[i]))
+            return false;
+    }
+    return true;
+}
+
+// An optional group is either absent (end of line) or complete
+bool ReadOptionalFloats(std::istream& stream, float* values, int count) {
+    if ((stream >> std::ws).eof())
+        return true;
+    return ReadFloats(stream, values, count);
+}
+
+// out = a * b, column-major 4x4
+void Multiply(const float* a, const float* b, float* out) {
+    float result[16];
+    for (int column = 0; column < 4; ++column) {
+        for (int row = 0; row < 4; ++row) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k)
+                sum += a[k * 4 + row] * b[column * 4 + k];
+            result[column * 4 + row] = sum;
+        }
+    }
+    std::memcpy(out, result, sizeof(result));
+}
+
+void Identity(float* matrix) {
+    std::memset(matrix, 0, 16 * sizeof(float));
+    matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.0f;
+}
+
+// Rotation by angle (radians) about one of the x, y, z axes
+void AxisRotation(int axis, float angle, float* matrix) {
+    Identity(matrix);
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    matrix[u * 4 + u] = c;
+    matrix[u * 4 + v] = s;
+    matrix[v * 4 + u] = -s;
+    matrix[v * 4 + v] = c;
+}
+
+// translation * rotZ * rotY * rotX * scale
+void ComposeTransform(const float* translation, const float* rotationDegrees, const float* scale, float* matrix) {
+    Identity(matrix);
+    for (int axis = 2; axis >= 0; --axis) {
+        float rotation[16];
+        AxisRotation(axis, rotationDegrees[axis] * kDegreesToRadians, rotation);
+        Multiply(matrix, rotation, matrix);
+    }
+    for (int column = 0; column < 3; ++column) {
+        for (int row = 0; row < 3; ++row)
+            matrix[column * 4 + row] *= scale[column];
+    }
+    matrix[12] = translation[0];
+    matrix[13] = translation[1];
+    matrix[14] = translation[2];
+}
+
+bool ParseManifest(const std::string& path, Manifest& manifest) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    std::map<std::string, uint32_t> meshIndices;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        std::istringstream stream(line);
+        std::string keyword;
+        if (!(stream >> keyword))
+            continue;
+
+        bool ok = true;
+        if (keyword == "mesh") {
+            PackedMesh mesh;
+            std::string objPath;
+            ok = (bool)(stream >> mesh.name >> objPath);
+            if (ok) {
+                if (meshIndices.count(mesh.name)) {
+                    std::cerr << path << ":" << lineNumber << ": mesh " << mesh.name << " defined twice" << std::endl;
+                    return false;
+                }
+                if (!LoadObj(objPath, mesh.geometry))
+                    return false;
+
+                MeshOptimizationStats stats = OptimizeMesh(mesh.geometry.vertices, mesh.geometry.indices);
+                std::cout << mesh.name << ": " << stats.verticesBefore << " -> " << stats.verticesAfter << " vertices, ACMR "
+                    << stats.before.acmr << " -> " << stats.after.acmr << ", ATVR " << stats.before.atvr << " -> "
+                    << stats.after.atvr << std::endl;
+
+                mesh.lods = GenerateLods(mesh.geometry.vertices, mesh.geometry.indices);
+                for (size_t lod = 1; lod < mesh.lods.size(); ++lod) {
+                    std::cout << "  LOD " << lod << ": " << mesh.lods[lod].indexCount / 3 << " triangles, error "
+                        << mesh.lods[lod].error << std::endl;
+                }
+                meshIndices[mesh.name] = (uint32_t)manifest.meshes.size();
+                manifest.meshes.push_back(std::move(mesh));
+            }
+        }
+        else if (keyword == "texture") {
+            std::string type, texturePath;
+            ok = (bool)(stream >> type >> texturePath) && !manifest.meshes.empty();
+            if (ok)
+                manifest.meshes.back().textures.emplace_back(type, texturePath);
+        }
+        else if (keyword == "object") {
+            std::string meshName;
+            float translation[3];
+            float rotation[3] = { 0.0f, 0.0f, 0.0f };
+            float scale[3] = { 1.0f, 1.0f, 1.0f };
+            ok = (bool)(stream >> meshName) && ReadFloats(stream, translation, 3) &&
+                ReadOptionalFloats(stream, rotation, 3) && ReadOptionalFloats(stream, scale, 3);
+
+            auto found = meshIndices.find(meshName);
+            if (ok && found == meshIndices.end()) {
+                std::cerr << path << ":" << lineNumber << ": unknown mesh " << meshName << std::endl;
+                return false;
+            }
+            if (ok) {
+                PackageObject object = {};
+                object.mesh = found->second;
+                ComposeTransform(translation, rotation, scale, object.transform);
+                manifest.objects.push_back(object);
+            }
+        }
+        else if (keyword == "directional" || keyword == "point" || keyword == "spot") {
+            PackageLight light = {};
+            bool hasDirection = keyword != "point";
+            light.type = keyword == "directional" ? kPackageDirectionalLight : keyword == "point" ? kPackagePointLight : kPackageSpotLight;
+            ok = ReadFloats(stream, light.position, 3) &&
+                (!hasDirection || ReadFloats(stream, light.direction, 3)) &&
+                ReadFloats(stream, light.ambient, 3) &&
+                ReadFloats(stream, light.diffuse, 3) &&
+                ReadFloats(stream, light.specular, 3);
+            if (ok && light.type != kPackageDirectionalLight) {
+                ok = ReadFloats(stream, &light.constant, 1) && ReadFloats(stream, &light.linear, 1) && ReadFloats(stream, &light.quadratic, 1);
+            }
+            if (ok && light.type == kPackageSpotLight) {
+                float angles[2];
+                ok = ReadFloats(stream, angles, 2);
+                light.cutOff = std::cos(angles[0] * kDegreesToRadians);
+                light.outerCutOff = std::cos(angles[1] * kDegreesToRadians);
+            }
+            if (ok)
+                manifest.lights.push_back(light);
+        }
+        else {
+            std::cerr << path << ":" << lineNumber << ": unknown keyword " << keyword << std::endl;
+            return false;
+        }
+
+        if (!ok) {
+            std::cerr << path << ":" << lineNumber << ": malformed " << keyword << " line" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t AlignUp(uint64_t offset) {
+    return (offset + kScenePackageAlignment - 1) & ~(uint64_t)(kScenePackageAlignment - 1);
+}
+
+// Same bounds Mesh computes at runtime: box, then a sphere on its centre reaching the farthest vertex
+void ComputeBounds(const ObjMesh& geometry, PackageMesh& mesh) {
+    for (int axis = 0; axis < 3; ++axis) {
+        mesh.boundsMin[axis] = geometry.vertices[0].position[axis];
+        mesh.boundsMax[axis] = geometry.vertices[0].position[axis];
+    }
+    for (const PackageVertex& vertex : geometry.vertices) {
+        for (int axis = 0; axis < 3; ++axis) {
+            mesh.boundsMin[axis] = std::min(mesh.boundsMin[axis], vertex.position[axis]);
+            mesh.boundsMax[axis] = std::max(mesh.boundsMax[axis], vertex.position[axis]);
+        }
+    }
+
+    float radiusSquared = 0.0f;
+    for (int axis = 0; axis < 3; ++axis)
+        mesh.sphere[axis] = (mesh.boundsMin[axis] + mesh.boundsMax[axis]) * 0.5f;
+    for (const PackageVertex& vertex : geometry.vertices) {
+        float dx = vertex.position[0] - mesh.sphere[0];
+        float dy = vertex.position[1] - mesh.sphere[1];
+        float dz = vertex.position[2] - mesh.sphere[2];
+        radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+    }
+    mesh.sphere[3] = std::sqrt(radiusSquared);
+}
+
+class PackageWriter {
+public:
+    explicit PackageWriter(std::ofstream& file) : file(file), position(0) {}
+
+    void Write(const void* data, size_t size) {
+        file.write((const char*)data, (std::streamsize)size);
+        position += size;
+    }
+
+    // Pads with zeros up to offset, which must not be behind the current position
+    void Seek(uint64_t offset) {
+        static const char zeros[kScenePackageAlignment] = {};
+        while (position < offset)
+            Write(zeros, (size_t)std::min<uint64_t>(offset - position, sizeof(zeros)));
+    }
+
+private:
+    std::ofstream& file;
+    uint64_t position;
+};
+
+bool WritePackage(const std::string& path, const Manifest& manifest) {
+    std::vector<PackageMesh> meshes;
+    std::vector<PackageTexture> textures;
+    std::string strings;
+    std::map<std::string, uint32_t> stringOffsets;
+
+    auto AddString = [&](const std::string& text) {
+        auto found = stringOffsets.find(text);
+        if (found != stringOffsets.end())
+            return found->second;
+        uint32_t offset = (uint32_t)strings.size();
+        strings.append(text);
+        strings.push_back('\0');
+        stringOffsets[text] = offset;
+        return offset;
+    };
+
+    for (const PackedMesh& packed : manifest.meshes) {
+        PackageMesh mesh = {};
+        mesh.vertexCount = (uint32_t)packed.geometry.vertices.size();
+        mesh.indexCount = (uint32_t)packed.geometry.indices.size();
+        for (uint32_t index : packed.geometry.indices)
+            mesh.maxIndex = std::max(mesh.maxIndex, index);
+        mesh.firstTexture = (uint32_t)textures.size();
+        mesh.textureCount = (uint32_t)packed.textures.size();
+        ComputeBounds(packed.geometry, mesh);
+        mesh.lodCount = (uint32_t)packed.lods.size();
+        for (size_t lod = 0; lod < packed.lods.size(); ++lod)
+            mesh.lods[lod] = { packed.lods[lod].firstIndex, packed.lods[lod].indexCount, packed.lods[lod].error };
+        for (const auto& texture : packed.textures) {
+            PackageTexture record;
+            record.typeOffset = AddString(texture.first);
+            record.pathOffset = AddString(texture.second);
+            textures.push_back(record);
+        }
+        meshes.push_back(mesh);
+    }
+
+    // Layout: header, tables, string table, then each mesh's vertex and index blobs
+    PackageHeader header = {};
+    header.magic = kScenePackageMagic;
+    header.version = kScenePackageVersion;
+    header.vertexSize = sizeof(PackageVertex);
+    header.meshCount = (uint32_t)meshes.size();
+    header.textureCount = (uint32_t)textures.size();
+    header.objectCount = (uint32_t)manifest.objects.size();
+    header.lightCount = (uint32_t)manifest.lights.size();
+    header.stringBytes = (uint32_t)strings.size();
+    header.meshTableOffset = AlignUp(sizeof(PackageHeader));
+    header.textureTableOffset = AlignUp(header.meshTableOffset + meshes.size() * sizeof(PackageMesh));
+    header.objectTableOffset = AlignUp(header.textureTableOffset + textures.size() * sizeof(PackageTexture));
+    header.lightTableOffset = AlignUp(header.objectTableOffset + manifest.objects.size() * sizeof(PackageObject));
+    header.stringTableOffset = AlignUp(header.lightTableOffset + manifest.lights.size() * sizeof(PackageLight));
+
+    uint64_t end = header.stringTableOffset + strings.size();
+    for (PackageMesh& mesh : meshes) {
+        mesh.vertexOffset = AlignUp(end);
+        mesh.indexOffset = AlignUp(mesh.vertexOffset + (uint64_t)mesh.vertexCount * sizeof(PackageVertex));
+        end = mesh.indexOffset + (uint64_t)mesh.indexCount * sizeof(uint32_t);
+    }
+    header.fileSize = end;
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to create " << path << std::endl;
+        return false;
+    }
+
+    PackageWriter writer(file);
+    writer.Write(&header, sizeof(header));
+    writer.Seek(header.meshTableOffset);
+    writer.Write(meshes.data(), meshes.size() * sizeof(PackageMesh));
+    writer.Seek(header.textureTableOffset);
+    writer.Write(textures.data(), textures.size() * sizeof(PackageTexture));
+    writer.Seek(header.objectTableOffset);
+    writer.Write(manifest.objects.data(), manifest.objects.size() * sizeof(PackageObject));
+    writer.Seek(header.lightTableOffset);
+    writer.Write(manifest.lights.data(), manifest.lights.size() * sizeof(PackageLight));
+    writer.Seek(header.stringTableOffset);
+    writer.Write(strings.data(), strings.size());
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        const ObjMesh& geometry = manifest.meshes[i].geometry;
+        writer.Seek(meshes[i].vertexOffset);
+        writer.Write(geometry.vertices.data(), geometry.vertices.size() * sizeof(PackageVertex));
+        writer.Seek(meshes[i].indexOffset);
+        writer.Write(geometry.indices.data(), geometry.indices.size() * sizeof(uint32_t));
+    }
+
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: ScenePacker manifest.txt output.gspk" << std::endl;
+        return 1;
+    }
+
+    Manifest manifest;
+    if (!ParseManifest(argv[1], manifest) || !WritePackage(argv[2], manifest)) {
+        return 1;
+    }
+
+    std::cout << argv[2] << ": " << manifest.meshes.size() << " meshes, " << manifest.objects.size() << " objects, "
+        << manifest.lights.size() << " lights" << std::endl;
+    return 0;
+}
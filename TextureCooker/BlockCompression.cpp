@@ -0,0 +1,189 @@
+#include "BlockCompression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+uint16_t PackRGB565(const float color[3]) {
+    int r = std::min(31, std::max(0, (int)std::lround(color[0] * 31.0f / 255.0f)));
+    int g = std::min(63, std::max(0, (int)std::lround(color[1] * 63.0f / 255.0f)));
+    int b = std::min(31, std::max(0, (int)std::lround(color[2] * 31.0f / 255.0f)));
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+void UnpackRGB565(uint16_t packed, float color[3]) {
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (float)((r << 3) | (r >> 2));
+    color[1] = (float)((g << 2) | (g >> 4));
+    color[2] = (float)((b << 3) | (b >> 2));
+}
+
+// Colour endpoints along the block's principal axis, pulled in slightly so the rounding of the
+// two interpolated palette entries lands closer to the data
+void PrincipalEndpoints(const uint8_t rgba[16 * 4], float minColor[3], float maxColor[3]) {
+    float mean[3] = {};
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            mean[c] += rgba[i * 4 + c];
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        mean[c] /= 16.0f;
+    }
+
+    float covariance[6] = {}; // xx xy xz yy yz zz
+    for (int i = 0; i < 16; ++i) {
+        float d[3] = { rgba[i * 4] - mean[0], rgba[i * 4 + 1] - mean[1], rgba[i * 4 + 2] - mean[2] };
+        covariance[0] += d[0] * d[0];
+        covariance[1] += d[0] * d[1];
+        covariance[2] += d[0] * d[2];
+        covariance[3] += d[1] * d[1];
+        covariance[4] += d[1] * d[2];
+        covariance[5] += d[2] * d[2];
+    }
+
+    // A few power iterations are enough to find the dominant eigenvector
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[3] = {
+            covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+            covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+            covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2] };
+        float length = std::max(std::fabs(next[0]), std::max(std::fabs(next[1]), std::fabs(next[2])));
+        if (length < 1e-6f)
+            break;
+        for (int c = 0; c < 3; ++c) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float minProjection = 1e30f, maxProjection = -1e30f;
+    for (int i = 0; i < 16; ++i) {
+        float projection = (rgba[i * 4] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] + (rgba[i * 4 + 2] - mean[2]) * axis[2];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    float axisLengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    if (axisLengthSquared < 1e-12f) {
+        axisLengthSquared = 1.0f;
+    }
+    float inset = (maxProjection - minProjection) / 16.0f;
+    for (int c = 0; c < 3; ++c) {
+        minColor[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * (minProjection + inset) / axisLengthSquared));
+        maxColor[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * (maxProjection - inset) / axisLengthSquared));
+    }
+}
+
+void EncodeColorBlock(const uint8_t rgba[16 * 4], uint8_t out[8]) {
+    float minColor[3], maxColor[3];
+    PrincipalEndpoints(rgba, minColor, maxColor);
+
+    uint16_t color0 = PackRGB565(maxColor);
+    uint16_t color1 = PackRGB565(minColor);
+    uint32_t indices = 0;
+
+    if (color0 != color1) {
+        // color0 > color1 selects the four-colour mode
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        float palette[4][3];
+        UnpackRGB565(color0, palette[0]);
+        UnpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        }
+
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            float bestError = 1e30f;
+            for (int p = 0; p < 4; ++p) {
+                float dr = rgba[i * 4] - palette[p][0];
+                float dg = rgba[i * 4 + 1] - palette[p][1];
+                float db = rgba[i * 4 + 2] - palette[p][2];
+                float error = dr * dr + dg * dg + db * db;
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= (uint32_t)best << (i * 2);
+        }
+    }
+
+    out[0] = (uint8_t)(color0 & 0xFF);
+    out[1] = (uint8_t)(color0 >> 8);
+    out[2] = (uint8_t)(color1 & 0xFF);
+    out[3] = (uint8_t)(color1 >> 8);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+} // namespace
+
+void EncodeBC1(const uint8_t rgba[16 * 4], uint8_t out[8]) {
+    EncodeColorBlock(rgba, out);
+}
+
+void EncodeBC3(const uint8_t rgba[16 * 4], uint8_t out[16]) {
+    uint8_t alpha[16];
+    for (int i = 0; i < 16; ++i) {
+        alpha[i] = rgba[i * 4 + 3];
+    }
+    EncodeBC4(alpha, out);
+    EncodeColorBlock(rgba, out + 8);
+}
+
+void EncodeBC4(const uint8_t values[16], uint8_t out[8]) {
+    int minValue = 255, maxValue = 0;
+    for (int i = 0; i < 16; ++i) {
+        minValue = std::min(minValue, (int)values[i]);
+        maxValue = std::max(maxValue, (int)values[i]);
+    }
+
+    out[0] = (uint8_t)maxValue;
+    out[1] = (uint8_t)minValue;
+    uint64_t indices = 0;
+
+    // With endpoint0 > endpoint1 the palette is both endpoints plus six evenly spaced values;
+    // equal endpoints leave every index at 0, which decodes to endpoint0
+    if (maxValue > minValue) {
+        float palette[8];
+        palette[0] = (float)maxValue;
+        palette[1] = (float)minValue;
+        for (int p = 1; p < 7; ++p) {
+            palette[p + 1] = ((7 - p) * maxValue + p * minValue) / 7.0f;
+        }
+
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            float bestError = 1e30f;
+            for (int p = 0; p < 8; ++p) {
+                float error = std::fabs(values[i] - palette[p]);
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= (uint64_t)best << (i * 3);
+        }
+    }
+
+    for (int i = 0; i < 6; ++i) {
+        out[2 + i] = (uint8_t)(indices >> (i * 8));
+    }
+}
+
+void EncodeBC5(const uint8_t rg[16 * 2], uint8_t out[16]) {
+    uint8_t red[16], green[16];
+    for (int i = 0; i < 16; ++i) {
+        red[i] = rg[i * 2];
+        green[i] = rg[i * 2 + 1];
+    }
+    EncodeBC4(red, out);
+    EncodeBC4(green, out + 8);
+}
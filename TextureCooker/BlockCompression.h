@@ -0,0 +1,13 @@
+#ifndef BLOCKCOMPRESSION_H
+#define BLOCKCOMPRESSION_H
+
+#include <cstdint>
+
+// Encoders for one 4x4 block. Input is 16 pixels in row-major order with the given number of
+// 8-bit channels per pixel (RGBA for BC1/BC3, a single channel for BC4, two for BC5).
+void EncodeBC1(const uint8_t rgba[16 * 4], uint8_t out[8]);
+void EncodeBC3(const uint8_t rgba[16 * 4], uint8_t out[16]);
+void EncodeBC4(const uint8_t values[16], uint8_t out[8]);
+void EncodeBC5(const uint8_t rg[16 * 2], uint8_t out[16]);
+
+#endif // BLOCKCOMPRESSION_H
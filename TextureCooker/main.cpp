@@ -0,0 +1,251 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "BlockCompression.h"
+#include "../Project1/DDS.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Offline texture cooker: converts source images into block-compressed DDS files with every
+// mip level precomputed, so the runtime uploads them with glCompressedTexImage2D and never
+// decodes or mipmaps at load time.
+//
+//   TextureCooker [--usage auto|color|mask|normal] [--out file.dds] input...
+//
+// color  -> BC1 (BC3 if the image has non-opaque alpha)
+// mask   -> BC4 from the red channel (AO, roughness, height)
+// normal -> BC5 from red/green; mips are renormalised before encoding
+// auto picks from the file name: NO/normal -> normal, AO/RO/rough/height -> mask, else color.
+
+namespace {
+
+enum class Usage { Auto, Color, Mask, Normal };
+
+// Float RGBA image, 0-255 range
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<float> pixels;
+
+    float* At(int x, int y) { return &pixels[((size_t)y * width + x) * 4]; }
+    const float* At(int x, int y) const { return &pixels[((size_t)y * width + x) * 4]; }
+};
+
+std::string ToLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return text;
+}
+
+Usage GuessUsage(const std::string& path) {
+    std::string name = ToLower(path.substr(path.find_last_of("/\\") + 1));
+    name = name.substr(0, name.find_last_of('.'));
+    if (name == "no" || name.find("normal") != std::string::npos)
+        return Usage::Normal;
+    if (name == "ao" || name == "ro" || name.find("rough") != std::string::npos || name.find("height") != std::string::npos ||
+        name.find("occlusion") != std::string::npos)
+        return Usage::Mask;
+    return Usage::Color;
+}
+
+std::string DefaultOutputPath(const std::string& input) {
+    size_t slash = input.find_last_of("/\\");
+    size_t dot = input.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return input + ".dds";
+    return input.substr(0, dot) + ".dds";
+}
+
+// 2x2 box filter; odd edges clamp. Normal maps are renormalised so shading does not flatten with distance.
+Image Downsample(const Image& source, bool normalMap) {
+    Image result;
+    result.width = std::max(1, source.width / 2);
+    result.height = std::max(1, source.height / 2);
+    result.pixels.resize((size_t)result.width * result.height * 4);
+
+    for (int y = 0; y < result.height; ++y) {
+        for (int x = 0; x < result.width; ++x) {
+            int x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+            int y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+            float* out = result.At(x, y);
+            for (int c = 0; c < 4; ++c) {
+                out[c] = 0.25f * (source.At(x0, y0)[c] + source.At(x1, y0)[c] + source.At(x0, y1)[c] + source.At(x1, y1)[c]);
+            }
+
+            if (normalMap) {
+                float n[3];
+                for (int c = 0; c < 3; ++c) {
+                    n[c] = out[c] / 127.5f - 1.0f;
+                }
+                float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (length > 1e-6f) {
+                    for (int c = 0; c < 3; ++c) {
+                        out[c] = (n[c] / length + 1.0f) * 127.5f;
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+uint8_t ToByte(float value) {
+    return (uint8_t)std::min(255.0f, std::max(0.0f, value + 0.5f));
+}
+
+// Appends one compressed mip level to image.data
+void EncodeLevel(const Image& level, DDSFormat format, DDSImage& image) {
+    size_t offset = image.data.size();
+    size_t size = DDSLevelSize(format, level.width, level.height);
+    image.levels.push_back({ (uint32_t)level.width, (uint32_t)level.height, offset, size });
+    image.data.resize(offset + size);
+
+    size_t blockBytes = DDSBlockBytes(format);
+    uint8_t* out = image.data.data() + offset;
+    for (int by = 0; by < level.height; by += 4) {
+        for (int bx = 0; bx < level.width; bx += 4) {
+            // Gather the block, clamping reads past the edge of levels smaller than 4x4
+            uint8_t rgba[16 * 4];
+            for (int i = 0; i < 16; ++i) {
+                const float* pixel = level.At(std::min(bx + i % 4, level.width - 1), std::min(by + i / 4, level.height - 1));
+                for (int c = 0; c < 4; ++c) {
+                    rgba[i * 4 + c] = ToByte(pixel[c]);
+                }
+            }
+
+            switch (format) {
+            case DDSFormat::BC1:
+                EncodeBC1(rgba, out);
+                break;
+            case DDSFormat::BC3:
+                EncodeBC3(rgba, out);
+                break;
+            case DDSFormat::BC4: {
+                uint8_t red[16];
+                for (int i = 0; i < 16; ++i) {
+                    red[i] = rgba[i * 4];
+                }
+                EncodeBC4(red, out);
+                break;
+            }
+            case DDSFormat::BC5: {
+                uint8_t rg[16 * 2];
+                for (int i = 0; i < 16; ++i) {
+                    rg[i * 2] = rgba[i * 4];
+                    rg[i * 2 + 1] = rgba[i * 4 + 1];
+                }
+                EncodeBC5(rg, out);
+                break;
+            }
+            default:
+                break;
+            }
+            out += blockBytes;
+        }
+    }
+}
+
+const char* FormatName(DDSFormat format) {
+    switch (format) {
+    case DDSFormat::BC1: return "BC1";
+    case DDSFormat::BC3: return "BC3";
+    case DDSFormat::BC4: return "BC4";
+    case DDSFormat::BC5: return "BC5";
+    default: return "?";
+    }
+}
+
+bool Cook(const std::string& input, const std::string& output, Usage usage) {
+    int width, height, channels;
+    unsigned char* data = stbi_load(input.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        std::cerr << "Failed to load " << input << std::endl;
+        return false;
+    }
+
+    Image level;
+    level.width = width;
+    level.height = height;
+    level.pixels.assign(data, data + (size_t)width * height * 4);
+    stbi_image_free(data);
+
+    if (usage == Usage::Auto)
+        usage = GuessUsage(input);
+
+    DDSFormat format = DDSFormat::BC4;
+    if (usage == Usage::Normal) {
+        format = DDSFormat::BC5;
+    }
+    else if (usage == Usage::Color) {
+        bool hasAlpha = false;
+        for (size_t i = 3; i < level.pixels.size() && !hasAlpha; i += 4) {
+            hasAlpha = level.pixels[i] < 255.0f;
+        }
+        format = hasAlpha ? DDSFormat::BC3 : DDSFormat::BC1;
+    }
+
+    DDSImage image;
+    image.format = format;
+    for (;;) {
+        EncodeLevel(level, format, image);
+        if (level.width == 1 && level.height == 1)
+            break;
+        level = Downsample(level, usage == Usage::Normal);
+    }
+
+    if (!WriteDDS(output, image)) {
+        std::cerr << "Failed to write " << output << std::endl;
+        return false;
+    }
+
+    size_t sourceBytes = (size_t)width * height * 4;
+    std::cout << input << " -> " << output << " (" << FormatName(format) << ", " << width << "x" << height << ", "
+        << image.levels.size() << " mips, " << image.data.size() / 1024 << " KB vs " << (sourceBytes + sourceBytes / 3) / 1024
+        << " KB as RGBA8)" << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Usage usage = Usage::Auto;
+    std::string output;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--usage" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "auto") usage = Usage::Auto;
+            else if (value == "color") usage = Usage::Color;
+            else if (value == "mask") usage = Usage::Mask;
+            else if (value == "normal") usage = Usage::Normal;
+            else {
+                std::cerr << "Unknown usage: " << value << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--out" && i + 1 < argc) {
+            output = argv[++i];
+        }
+        else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (inputs.empty() || (!output.empty() && inputs.size() > 1)) {
+        std::cerr << "Usage: TextureCooker [--usage auto|color|mask|normal] [--out file.dds] input..." << std::endl;
+        return 1;
+    }
+
+    int failures = 0;
+    for (const auto& input : inputs) {
+        if (!Cook(input, output.empty() ? DefaultOutputPath(input) : output, usage))
+            ++failures;
+    }
+    return failures == 0 ? 0 : 1;
+}